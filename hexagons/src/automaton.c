@@ -0,0 +1,173 @@
+/*
+ *   Copyright (C) 2015 Maxime Chevallier
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software Foundation,
+ *   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ *
+ *   Hexagonal cellular automaton. The whole grid is packed in a 64 bit word,
+ *   bit (8 * column + half_row) being the cell at that position. Neighbor
+ *   columns are offset by half a row, so the 6 neighbors of a cell are at
+ *   fixed bit distances, and a generation is a handful of shifts and logical
+ *   operations on the whole grid at once.
+ *
+ *   A shift that wraps from a column to the next one always lands on a
+ *   position of the wrong parity, where no cell can be, so no masking is
+ *   needed before counting.
+ */
+
+#include <automaton.h>
+
+#define GRID_ROWS 8
+#define GRID_COLUMNS 8
+
+/* Bit distances of the neighbors : same column, and next column up / down */
+#define SHIFT_VERTICAL 2
+#define SHIFT_UP (GRID_ROWS - 1)
+#define SHIFT_DOWN (GRID_ROWS + 1)
+
+static uint64_t s_valid;
+static uint64_t s_state;
+static uint64_t s_pinned;
+static int8_t s_bit_of_cell[AUTOMATON_MAX_CELLS];
+static int16_t s_nb_cells;
+
+/**
+ * @brief returns the smallest non zero distance between two values
+ */
+static int16_t min_distance(const int16_t *values, int16_t nb_values){
+    int16_t i, j, d, min = INT16_MAX;
+
+    for(i = 0; i < nb_values; i++){
+        for(j = 0; j < nb_values; j++){
+            d = values[i] - values[j];
+            if( d > 0 && d < min )
+                min = d;
+        }
+    }
+    return min;
+}
+
+bool automaton_init(const GPoint *origins, int16_t nb_cells){
+    int16_t xs[AUTOMATON_MAX_CELLS];
+    int16_t ys[AUTOMATON_MAX_CELLS];
+    int16_t min_x = INT16_MAX, min_y = INT16_MAX;
+    int16_t pitch_x, pitch_y, column, row, i;
+
+    if( nb_cells > AUTOMATON_MAX_CELLS )
+        return false;
+
+    for(i = 0; i < nb_cells; i++){
+        xs[i] = origins[i].x;
+        ys[i] = origins[i].y;
+        if( xs[i] < min_x )
+            min_x = xs[i];
+        if( ys[i] < min_y )
+            min_y = ys[i];
+    }
+
+    /* Columns are a full step apart, half rows half a step */
+    pitch_x = min_distance(xs, nb_cells);
+    pitch_y = min_distance(ys, nb_cells);
+
+    s_valid = 0;
+    s_state = 0;
+    s_pinned = 0;
+    s_nb_cells = nb_cells;
+    for(i = 0; i < nb_cells; i++){
+        column = (xs[i] - min_x + pitch_x / 2) / pitch_x;
+        row = (ys[i] - min_y + pitch_y / 2) / pitch_y;
+        if( column >= GRID_COLUMNS || row >= GRID_ROWS ){
+            /* Leave an empty automaton rather than a partly mapped one */
+            s_valid = 0;
+            s_nb_cells = 0;
+            return false;
+        }
+
+        s_bit_of_cell[i] = column * GRID_ROWS + row;
+        s_valid |= (uint64_t)1 << s_bit_of_cell[i];
+    }
+    return true;
+}
+
+static uint64_t cells_to_bits(uint32_t cells){
+    uint64_t bits = 0;
+    int16_t i;
+
+    for(i = 0; i < s_nb_cells; i++){
+        if( cells & ((uint32_t)1 << i) )
+            bits |= (uint64_t)1 << s_bit_of_cell[i];
+    }
+    return bits;
+}
+
+static uint32_t bits_to_cells(uint64_t bits){
+    uint32_t cells = 0;
+    int16_t i;
+
+    for(i = 0; i < s_nb_cells; i++){
+        if( bits & ((uint64_t)1 << s_bit_of_cell[i]) )
+            cells |= (uint32_t)1 << i;
+    }
+    return cells;
+}
+
+void automaton_set_pinned(uint32_t cells){
+    s_pinned = cells_to_bits(cells);
+}
+
+void automaton_set_cells(uint32_t cells){
+    s_state = cells_to_bits(cells) | s_pinned;
+}
+
+uint32_t automaton_get_cells(void){
+    return bits_to_cells(s_state);
+}
+
+/**
+ * @brief Adds a neighbor word to the bit sliced counter c2 c1 c0. There are
+ * at most 6 neighbors, 3 bits are enough.
+ */
+static void count_neighbors(uint64_t *c0, uint64_t *c1, uint64_t *c2, uint64_t neighbors){
+    uint64_t carry0 = *c0 & neighbors;
+    uint64_t carry1;
+
+    *c0 ^= neighbors;
+    carry1 = *c1 & carry0;
+    *c1 ^= carry0;
+    *c2 |= carry1;
+}
+
+uint32_t automaton_step(void){
+    uint64_t c0 = 0, c1 = 0, c2 = 0;
+    uint64_t two, three, four, next;
+    uint64_t previous = s_state;
+
+    count_neighbors(&c0, &c1, &c2, previous << SHIFT_VERTICAL);
+    count_neighbors(&c0, &c1, &c2, previous >> SHIFT_VERTICAL);
+    count_neighbors(&c0, &c1, &c2, previous << SHIFT_UP);
+    count_neighbors(&c0, &c1, &c2, previous >> SHIFT_UP);
+    count_neighbors(&c0, &c1, &c2, previous << SHIFT_DOWN);
+    count_neighbors(&c0, &c1, &c2, previous >> SHIFT_DOWN);
+
+    two = ~c2 & c1 & ~c0;
+    three = ~c2 & c1 & c0;
+    four = c2 & ~c1 & ~c0;
+
+    next = s_valid & ((~previous & two) | (previous & (three | four)));
+    next |= s_pinned;
+
+    s_state = next;
+
+    return bits_to_cells(previous ^ next);
+}
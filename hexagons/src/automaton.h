@@ -0,0 +1,62 @@
+/*
+ *   Copyright (C) 2015 Maxime Chevallier
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software Foundation,
+ *   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ *
+ *   Hexagonal cellular automaton header file
+ */
+
+#include <pebble.h>
+
+#ifndef AUTOMATON_H
+#define	AUTOMATON_H
+
+#define AUTOMATON_MAX_CELLS 32
+
+/**
+ * @brief Maps the cells to the automaton grid. The cells must form a grid of
+ * flat topped hexagons, with at most 8 columns and 8 half rows.
+ * @param origins the position of each cell
+ * @param nb_cells at most AUTOMATON_MAX_CELLS
+ * @return false if the cells do not fit in the automaton grid
+ */
+bool automaton_init(const GPoint *origins, int16_t nb_cells);
+
+/**
+ * @brief Sets the cells that are always alive
+ * @param cells a mask of cells, bit i being cell i
+ */
+void automaton_set_pinned(uint32_t cells);
+
+/**
+ * @brief Sets the living cells
+ * @param cells a mask of cells, bit i being cell i
+ */
+void automaton_set_cells(uint32_t cells);
+
+/**
+ * @brief returns the mask of the living cells
+ */
+uint32_t automaton_get_cells(void);
+
+/**
+ * @brief Computes the next generation : a dead cell with 2 living neighbors is
+ * born, a living cell with 3 or 4 living neighbors survives.
+ * @return the mask of the cells whose state flipped
+ */
+uint32_t automaton_step(void);
+
+#endif	/* AUTOMATON_H */
+
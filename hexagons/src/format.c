@@ -0,0 +1,159 @@
+/*
+ *   Copyright (C) 2015 Maxime Chevallier
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software Foundation,
+ *   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ *
+ *   Allocation-free date and number formatting. This replaces strftime and
+ *   snprintf on the tick path : we only ever need two digit numbers and
+ *   short names, so the libc formatting machinery is not worth its cost.
+ *
+ */
+
+#include <format.h>
+
+/* "00" "01" ... "99", two chars per entry */
+static const char s_two_digits[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+typedef struct{
+    const char *locale;
+    const char *months[12];
+    const char *days[7];
+} t_date_names;
+
+static const t_date_names s_date_names[] = {
+    { "en",
+      { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+        "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" },
+      { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" } },
+    { "fr",
+      { "jan", "fév", "mar", "avr", "mai", "jun",
+        "jul", "aoû", "sep", "oct", "nov", "déc" },
+      { "dim", "lun", "mar", "mer", "jeu", "ven", "sam" } },
+    { "de",
+      { "Jan", "Feb", "Mär", "Apr", "Mai", "Jun",
+        "Jul", "Aug", "Sep", "Okt", "Nov", "Dez" },
+      { "So", "Mo", "Di", "Mi", "Do", "Fr", "Sa" } },
+    { "es",
+      { "ene", "feb", "mar", "abr", "may", "jun",
+        "jul", "ago", "sep", "oct", "nov", "dic" },
+      { "dom", "lun", "mar", "mié", "jue", "vie", "sáb" } },
+    { "it",
+      { "gen", "feb", "mar", "apr", "mag", "giu",
+        "lug", "ago", "set", "ott", "nov", "dic" },
+      { "dom", "lun", "mar", "mer", "gio", "ven", "sab" } },
+    { "pt",
+      { "jan", "fev", "mar", "abr", "mai", "jun",
+        "jul", "ago", "set", "out", "nov", "dez" },
+      { "dom", "seg", "ter", "qua", "qui", "sex", "sáb" } },
+};
+
+#define NB_DATE_NAMES (sizeof(s_date_names) / sizeof(s_date_names[0]))
+
+/* English until format_init() says otherwise */
+static const t_date_names *s_names = &s_date_names[0];
+
+void format_init(void){
+    const char *locale = i18n_get_system_locale();
+    unsigned int i;
+
+    s_names = &s_date_names[0];
+    for(i = 0; i < NB_DATE_NAMES; i++){
+        if( strncmp(locale, s_date_names[i].locale, 2) == 0 ){
+            s_names = &s_date_names[i];
+            break;
+        }
+    }
+}
+
+void format_two_digits(char *buffer, int value){
+    buffer[0] = s_two_digits[2 * value];
+    buffer[1] = s_two_digits[2 * value + 1];
+    buffer[2] = '\0';
+}
+
+void format_uint(char *buffer, int value){
+    if( value >= 100 ){
+        *buffer++ = '0' + value / 100;
+        value %= 100;
+        format_two_digits(buffer, value);
+    }else if( value >= 10 ){
+        format_two_digits(buffer, value);
+    }else{
+        buffer[0] = '0' + value;
+        buffer[1] = '\0';
+    }
+}
+
+void format_hour(char *buffer, const struct tm *tick_time, bool is_24h){
+    int hour = tick_time->tm_hour;
+
+    if( !is_24h ){
+        hour %= 12;
+        if( hour == 0 )
+            hour = 12;
+    }
+    format_two_digits(buffer, hour);
+}
+
+/**
+ * @brief returns the weekday of December 31st, 0 being Sunday
+ * @param year the full year, e.g. 2015
+ */
+static int last_day_of_year_wday(int year){
+    return (year + year / 4 - year / 100 + year / 400) % 7;
+}
+
+/**
+ * @brief returns the number of ISO weeks in a year ( 52 or 53 ). A year has
+ * 53 weeks when it ends on a Thursday, or when the year before ends on a
+ * Wednesday.
+ * @param year the full year
+ */
+static int iso_weeks_in_year(int year){
+    if( last_day_of_year_wday(year) == 4 || last_day_of_year_wday(year - 1) == 3 )
+        return 53;
+    return 52;
+}
+
+int format_iso_week(const struct tm *tick_time){
+    int year = tick_time->tm_year + 1900;
+    /* Monday = 0 ... Sunday = 6 */
+    int wday = (tick_time->tm_wday + 6) % 7;
+    int week = (tick_time->tm_yday - wday + 10) / 7;
+
+    if( week < 1 )
+        return iso_weeks_in_year(year - 1);
+    if( week > iso_weeks_in_year(year) )
+        return 1;
+    return week;
+}
+
+const char *format_month_abbr(const struct tm *tick_time){
+    return s_names->months[tick_time->tm_mon];
+}
+
+const char *format_day_abbr(const struct tm *tick_time){
+    return s_names->days[tick_time->tm_wday];
+}
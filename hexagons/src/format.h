@@ -0,0 +1,76 @@
+/*
+ *   Copyright (C) 2015 Maxime Chevallier
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software Foundation,
+ *   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ *
+ *   Allocation-free date and number formatting header file
+ */
+
+#include <pebble.h>
+
+#ifndef FORMAT_H
+#define	FORMAT_H
+
+/**
+ * @brief Selects the month and day name tables matching the watch language.
+ * Must be called once before format_month_abbr() and format_day_abbr().
+ */
+void format_init(void);
+
+/**
+ * @brief Writes value as two digits, with a leading zero ( same as "%02d" )
+ * @param buffer destination, at least 3 chars long
+ * @param value number in the 0-99 range
+ */
+void format_two_digits(char *buffer, int value);
+
+/**
+ * @brief Writes value without leading zeroes ( same as "%d" )
+ * @param buffer destination, at least 4 chars long
+ * @param value number in the 0-999 range
+ */
+void format_uint(char *buffer, int value);
+
+/**
+ * @brief Writes the hour, same as strftime's "%H" or "%I"
+ * @param buffer destination, at least 3 chars long
+ * @param tick_time
+ * @param is_24h
+ */
+void format_hour(char *buffer, const struct tm *tick_time, bool is_24h);
+
+/**
+ * @brief Computes the ISO 8601 week number, same as strftime's "%V"
+ * @param tick_time
+ * @return the week number, between 1 and 53
+ */
+int format_iso_week(const struct tm *tick_time);
+
+/**
+ * @brief returns the abbreviated month name, same as strftime's "%b"
+ * @param tick_time
+ * @return a constant string, never to be freed
+ */
+const char *format_month_abbr(const struct tm *tick_time);
+
+/**
+ * @brief returns the abbreviated day name, same as strftime's "%a"
+ * @param tick_time
+ * @return a constant string, never to be freed
+ */
+const char *format_day_abbr(const struct tm *tick_time);
+
+#endif	/* FORMAT_H */
+
@@ -0,0 +1,173 @@
+/*
+ *   Copyright (C) 2015 Maxime Chevallier
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software Foundation,
+ *   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ *
+ *   Hourly step count heatmap. The step count of each hour is queried once,
+ *   when the hour ends, and kept in a small ring buffer that survives restarts
+ *   of the watchface. Hours whose steps were not available are shown empty,
+ *   and queried again at the next update.
+ *
+ */
+
+#include <heatmap.h>
+
+#define PERSIST_KEY_HEATMAP 1
+
+#define NB_LEVELS 8
+
+/* Steps needed to reach each level of the ramp, level 0 being no steps */
+static const uint16_t s_level_steps[NB_LEVELS] = {
+    0, 1, 250, 500, 1000, 2000, 3000, 5000
+};
+
+static const GColor8 s_ramp[NB_LEVELS] = {
+    { GColorOxfordBlueARGB8 },
+    { GColorDukeBlueARGB8 },
+    { GColorBlueARGB8 },
+    { GColorIslamicGreenARGB8 },
+    { GColorGreenARGB8 },
+    { GColorYellowARGB8 },
+    { GColorChromeYellowARGB8 },
+    { GColorRedARGB8 }
+};
+
+/* Persisted as is, keep it small */
+typedef struct{
+    /* Start of the last hour whose bucket is up to date */
+    int32_t last_hour;
+    uint16_t steps[HEATMAP_HOURS];
+} t_heatmap_buckets;
+
+static t_heatmap_buckets s_buckets;
+static uint8_t s_levels[HEATMAP_HOURS];
+
+static time_t hour_start(time_t t){
+    return t - (t % SECONDS_PER_HOUR);
+}
+
+static int hour_slot(time_t t){
+    return (t / SECONDS_PER_HOUR) % HEATMAP_HOURS;
+}
+
+static uint8_t steps_level(uint16_t steps){
+    uint8_t level = NB_LEVELS - 1;
+
+    while( level > 0 && steps < s_level_steps[level] )
+        level--;
+    return level;
+}
+
+/**
+ * @brief Sets the bucket of the hour starting at start, and tells whether its
+ * color changed.
+ * @return the mask of the slot if its color changed, 0 otherwise
+ */
+static uint16_t heatmap_set_bucket(time_t start, int32_t steps){
+    int slot = hour_slot(start);
+    uint8_t level;
+
+    if( steps < 0 )
+        steps = 0;
+    if( steps > UINT16_MAX )
+        steps = UINT16_MAX;
+
+    s_buckets.steps[slot] = steps;
+    level = steps_level(steps);
+    if( level == s_levels[slot] )
+        return 0;
+
+    s_levels[slot] = level;
+    return 1 << slot;
+}
+
+/**
+ * @brief Sums the steps of the hour starting at start
+ * @return the step count, -1 if it is not available ( no health service,
+ * permission denied, or no data yet )
+ */
+static int32_t heatmap_query(time_t start){
+#if defined(PBL_HEALTH)
+    time_t end = start + SECONDS_PER_HOUR;
+
+    if( !(health_service_metric_accessible(HealthMetricStepCount, start, end) &
+          HealthServiceAccessibilityMaskAvailable) )
+        return -1;
+    return health_service_sum(HealthMetricStepCount, start, end);
+#else
+    return -1;
+#endif
+}
+
+/**
+ * @brief Fills the buckets of all the hours that ended since the last one
+ * that was stored, and clears the bucket of the hour in progress. The stored
+ * hours stop before the first hour that was not available, so that it is
+ * queried again once the data is there.
+ */
+static uint16_t heatmap_catch_up(time_t now){
+    time_t current = hour_start(now);
+    time_t start = s_buckets.last_hour + SECONDS_PER_HOUR;
+    time_t last_hour = current - SECONDS_PER_HOUR;
+    uint16_t changed = 0;
+    bool missing = false;
+    int32_t steps;
+
+    if( start > current )
+        return 0;
+
+    /* Older hours would be overwritten anyway */
+    if( start < current - (HEATMAP_HOURS - 1) * SECONDS_PER_HOUR )
+        start = current - (HEATMAP_HOURS - 1) * SECONDS_PER_HOUR;
+
+    for( ; start < current; start += SECONDS_PER_HOUR ){
+        steps = heatmap_query(start);
+        if( steps < 0 && !missing ){
+            missing = true;
+            last_hour = start - SECONDS_PER_HOUR;
+        }
+        changed |= heatmap_set_bucket(start, steps);
+    }
+
+    changed |= heatmap_set_bucket(current, 0);
+
+    s_buckets.last_hour = last_hour;
+    persist_write_data(PERSIST_KEY_HEATMAP, &s_buckets, sizeof(s_buckets));
+
+    return changed;
+}
+
+uint16_t heatmap_init(time_t now){
+    int i;
+
+    memset(&s_buckets, 0, sizeof(s_buckets));
+    if( persist_exists(PERSIST_KEY_HEATMAP) )
+        persist_read_data(PERSIST_KEY_HEATMAP, &s_buckets, sizeof(s_buckets));
+
+    for(i = 0; i < HEATMAP_HOURS; i++)
+        s_levels[i] = steps_level(s_buckets.steps[i]);
+
+    heatmap_catch_up(now);
+
+    return (1 << HEATMAP_HOURS) - 1;
+}
+
+uint16_t heatmap_update(time_t now){
+    return heatmap_catch_up(now);
+}
+
+GColor heatmap_get_color(int slot){
+    return s_ramp[s_levels[slot]];
+}
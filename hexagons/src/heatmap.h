@@ -0,0 +1,55 @@
+/*
+ *   Copyright (C) 2015 Maxime Chevallier
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software Foundation,
+ *   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ *
+ *   Hourly step count heatmap header file
+ */
+
+#include <pebble.h>
+
+#ifndef HEATMAP_H
+#define	HEATMAP_H
+
+/* Number of hourly buckets, one per heatmap hexagon */
+#define HEATMAP_HOURS 12
+
+/**
+ * @brief Loads the persisted buckets, and fetches the hours that were missed
+ * while the watchface was not running.
+ * @param now the current time
+ * @return a mask of the slots whose color must be set ( all of them )
+ */
+uint16_t heatmap_init(time_t now);
+
+/**
+ * @brief Closes the hour that just ended and saves the buckets. Only one
+ * health query is made, plus one per earlier hour that was not available
+ * yet, and only the slots whose color changed are reported.
+ * @param now the current time
+ * @return a mask of the slots whose color changed
+ */
+uint16_t heatmap_update(time_t now);
+
+/**
+ * @brief returns the color of a slot. The slot of an hour is its index since
+ * the epoch, modulo HEATMAP_HOURS.
+ * @param slot
+ * @return
+ */
+GColor heatmap_get_color(int slot);
+
+#endif	/* HEATMAP_H */
+
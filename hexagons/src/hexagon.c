@@ -16,247 +16,1033 @@
  *   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
  *
  *   Hexagon drawing utilities
- * 
+ *
  */
 
 #include <hexagon.h>
 
 #define HEX_HEIGHT(s) ((float)s * HALF_SQRT_3)
 
-struct _hexagon_layer_data{
-    GColor color;
-    GPath *path;
-    GColor border_color;
-    GPath *border_path;
-    int16_t border_width;
+#if defined(PBL_COLOR) && HEXAGON_PALETTE_RENDERING
+#define HEXAGON_PALETTE_BANDS 1
+#else
+#define HEXAGON_PALETTE_BANDS 0
+#endif
+
+/* Also the fallback of the palette bands, when a row holds too many hexagons */
+#if defined(PBL_COLOR) && (HEXAGON_PALETTE_BANDS || \
+    HEXAGON_FRAMEBUFFER_RENDERING || HEXAGON_ANTIALIASING)
+#define HEXAGON_FRAMEBUFFER_SPANS 1
+#else
+#define HEXAGON_FRAMEBUFFER_SPANS 0
+#endif
+
+#if HEXAGON_FRAMEBUFFER_SPANS && HEXAGON_ANTIALIASING && !HEXAGON_PALETTE_BANDS
+#define HEXAGON_AA_SPANS 1
+#else
+#define HEXAGON_AA_SPANS 0
+#endif
+
+/* The hexagons are rasterized by this file, instead of GPath */
+#if defined(PBL_BW) || HEXAGON_PALETTE_BANDS || HEXAGON_FRAMEBUFFER_SPANS
+#define HEXAGON_SOFTWARE_SPANS 1
+#else
+#define HEXAGON_SOFTWARE_SPANS 0
+#endif
+
+/**
+ * First and last pixel of a row of an hexagon, relative to the hexagon
+ * origin. The row is empty when left > right. The pixels just outside the
+ * row, left - 1 and right + 1, are partly covered by the slanted edges.
+ */
+typedef struct{
+    int8_t left;
+    int8_t right;
+    /* From 0 to HEXAGON_COVERAGE_LEVELS - 1 */
+    uint8_t coverage;
+} t_hexagon_span;
+
+#define HEXAGON_COVERAGE_LEVELS 4
+
+/**
+ * Horizontal slice of a grid rasterized in a 4 bit palette bitmap. Each
+ * hexagon crossing the band has its own palette slot.
+ */
+typedef struct{
+    GBitmap *bitmap;
+    GColor *palette;
+    int16_t y;
+    /* Palette slot of each hexagon of the grid, 0 when it is not in the band */
+    uint8_t *slots;
+} t_hexagon_band;
+
+/**
+ * Software rendering state of a grid, allocated along with its spans
+ */
+struct _hexagon_raster{
+    /* Rows of the fill, and of the outer and inner edges of the border */
+    t_hexagon_span *spans;
+    t_hexagon_span *border_outer_spans;
+    t_hexagon_span *border_inner_spans;
+    /* Only used for the palette rendering, built at the first draw */
+    t_hexagon_band *bands;
+    int16_t nb_bands;
+    /* Too many hexagons on a row for the bands, drawn without them */
+    bool bands_overflow;
+};
+
+/* Palette slots of a band : transparent background, border, then hexagons */
+#define BAND_SLOT_CLEAR 0
+#define BAND_SLOT_BORDER 1
+#define BAND_FIRST_SLOT 2
+#define BAND_NB_SLOTS 16
+
+#if defined(PBL_BW)
+/* 4x4 ordered dithering patterns, from black (0) to white (16). Each byte holds
+ * one row of 8 pixels, the pattern repeating every 4 pixels and 4 rows. */
+static const uint8_t s_dither_patterns[17][4] = {
+    { 0x00, 0x00, 0x00, 0x00 },
+    { 0x11, 0x00, 0x00, 0x00 },
+    { 0x11, 0x00, 0x44, 0x00 },
+    { 0x55, 0x00, 0x44, 0x00 },
+    { 0x55, 0x00, 0x55, 0x00 },
+    { 0x55, 0x22, 0x55, 0x00 },
+    { 0x55, 0x22, 0x55, 0x88 },
+    { 0x55, 0xAA, 0x55, 0x88 },
+    { 0x55, 0xAA, 0x55, 0xAA },
+    { 0x77, 0xAA, 0x55, 0xAA },
+    { 0x77, 0xAA, 0xDD, 0xAA },
+    { 0xFF, 0xAA, 0xDD, 0xAA },
+    { 0xFF, 0xAA, 0xFF, 0xAA },
+    { 0xFF, 0xBB, 0xFF, 0xAA },
+    { 0xFF, 0xBB, 0xFF, 0xEE },
+    { 0xFF, 0xFF, 0xFF, 0xEE },
+    { 0xFF, 0xFF, 0xFF, 0xFF },
 };
 
+/* Hand picked levels of the sweep colors, in the order of the sweep. Their
+ * luminance leaves green and orange, or cyan and pink, only a few pixels
+ * apart, so the levels alternate between dark and light instead, and two
+ * following colors always look different. Other colors use their luminance. */
+static const struct{
+    uint8_t argb;
+    uint8_t level;
+} s_dither_levels[] = {
+    { GColorGreenARGB8, 6 },
+    { GColorOrangeARGB8, 16 },
+    { GColorCyanARGB8, 9 },
+    { GColorShockingPinkARGB8, 15 },
+    { GColorYellowARGB8, 8 },
+    { GColorRedARGB8, 13 },
+};
+#endif
+
+#if HEXAGON_SOFTWARE_SPANS
+static int16_t floor_to_int(float value){
+    int16_t i = (int16_t)value;
+    if( value < i )
+        i--;
+    return i;
+}
+
+static int16_t ceil_to_int(float value){
+    int16_t i = (int16_t)value;
+    if( value > i )
+        i++;
+    return i;
+}
+
+/* Vertical samples per row when computing the edge coverage */
+#define COVERAGE_SAMPLES 4
+
+/**
+ * @brief returns the part of the pixel at x covered by the hexagon, from its
+ * left edge, averaged over the height of the row
+ */
+static float hexagon_edge_coverage(int16_t row, int16_t x,
+                                   float center_x, float center_y,
+                                   float side_width, float half_height){
+    float covered = 0;
+    float dy, edge, c;
+    int16_t i;
+
+    for(i = 0; i < COVERAGE_SAMPLES; i++){
+        dy = row + (i + 0.5f) / COVERAGE_SAMPLES - center_y;
+        if( dy < 0 )
+            dy = -dy;
+        if( dy > half_height )
+            continue;
+
+        edge = center_x - (side_width - (side_width / 2) * (dy / half_height));
+        c = x + 1 - edge;
+        if( c > 1 )
+            c = 1;
+        if( c > 0 )
+            covered += c;
+    }
+    return covered / COVERAGE_SAMPLES;
+}
+
+/**
+ * @brief Computes the pixel rows of an hexagon. A pixel belongs to the hexagon
+ * when its center is inside it. The coverage of the pixels next to each row
+ * is precomputed too : the slanted edges all have the same slope, so the row
+ * is symmetrical.
+ * @param spans one span per row
+ * @param nb_rows
+ * @param center_x center of the hexagon, relative to the rows origin
+ * @param center_y
+ * @param side_width
+ * @param half_height
+ */
+static void hexagon_compute_spans(t_hexagon_span *spans, int16_t nb_rows,
+                                  float center_x, float center_y,
+                                  float side_width, float half_height){
+    int16_t row;
+    float dy, half_width;
+
+    for(row = 0; row < nb_rows; row++){
+        dy = row + 0.5f - center_y;
+        if( dy < 0 )
+            dy = -dy;
+
+        if( dy > half_height ){
+            spans[row].left = 1;
+            spans[row].right = 0;
+            spans[row].coverage = 0;
+            continue;
+        }
+
+        /* From side_width on the middle row, to side_width / 2 on the top
+         * and bottom edges */
+        half_width = side_width - (side_width / 2) * (dy / half_height);
+        spans[row].left = ceil_to_int(center_x - half_width - 0.5f);
+        spans[row].right = floor_to_int(center_x + half_width - 0.5f);
+        spans[row].coverage = (HEXAGON_COVERAGE_LEVELS - 1) *
+            hexagon_edge_coverage(row, spans[row].left - 1,
+                                  center_x, center_y,
+                                  side_width, half_height) + 0.5f;
+    }
+}
+#endif
+
+static t_hexagon_grid *hexagon_grid_get_layer_data(Layer *layer){
+    t_hexagon_grid **layer_data = layer_get_data( layer );
+    return *layer_data;
+}
+
+/**
+ * @brief Vertical position of an hexagon once the grid fits the visible
+ * height : the centers get closer, the hexagons keep their size
+ */
+static int16_t hexagon_get_draw_y(t_hexagon_grid *grid, t_hexagon *hexagon){
+    int32_t center_y = hexagon->origin.y + grid->height / 2;
+
+    if( grid->visible_height == grid->full_height )
+        return hexagon->origin.y;
+    return center_y * grid->visible_height / grid->full_height - grid->height / 2;
+}
+
+static bool hexagon_is_visible(t_hexagon_grid *grid, t_hexagon *hexagon){
+    int16_t y = hexagon_get_draw_y(grid, hexagon);
+    return y < grid->visible_height && y + grid->height > 0;
+}
+
+static GPoint hexagon_get_draw_origin(t_hexagon_grid *grid, t_hexagon *hexagon){
+    return GPoint(hexagon->origin.x, hexagon_get_draw_y(grid, hexagon));
+}
+
+static void hexagon_draw_label( GContext *context, t_hexagon_label *label, GPoint origin ){
+    GRect box;
+
+    if( !label || label->hidden )
+        return;
+
+    box = label->box;
+    box.origin.x += origin.x;
+    box.origin.y += origin.y;
+
+    graphics_context_set_text_color(context, label->color);
+    graphics_draw_text(context, label->text, label->font, box,
+                       GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
+}
+
+#if defined(PBL_BW)
+static const uint8_t *hexagon_dither_pattern(GColor color){
+    /* Perceived brightness, from 0 to 24 */
+    int16_t luminance = 2 * color.r + 5 * color.g + color.b;
+    uint16_t i;
+
+    for(i = 0; i < ARRAY_LENGTH(s_dither_levels); i++){
+        if( s_dither_levels[i].argb == color.argb )
+            return s_dither_patterns[s_dither_levels[i].level];
+    }
+    return s_dither_patterns[luminance * 16 / 24];
+}
+
+/**
+ * @brief Sets the pixels x0 to x1 of a 1 bit framebuffer row to the pattern
+ */
+static void hexagon_fill_row(uint8_t *row, int16_t x0, int16_t x1,
+                             int16_t width, uint8_t pattern){
+    int16_t b0, b1, b;
+    uint8_t m0, m1;
+
+    if( x0 < 0 )
+        x0 = 0;
+    if( x1 >= width )
+        x1 = width - 1;
+    if( x0 > x1 )
+        return;
+
+    /* The leftmost pixel is the least significant bit */
+    b0 = x0 >> 3;
+    b1 = x1 >> 3;
+    m0 = 0xFF << (x0 & 7);
+    m1 = 0xFF >> (7 - (x1 & 7));
+
+    if( b0 == b1 ){
+        m0 &= m1;
+        row[b0] = (row[b0] & ~m0) | (pattern & m0);
+        return;
+    }
+
+    row[b0] = (row[b0] & ~m0) | (pattern & m0);
+    for(b = b0 + 1; b < b1; b++)
+        row[b] = pattern;
+    row[b1] = (row[b1] & ~m1) | (pattern & m1);
+}
+
+/**
+ * @brief Fills the hexagons with dithering patterns, directly in the 1 bit
+ * framebuffer. The grid layer must be at the origin of the screen.
+ */
+static void hexagon_grid_draw_dithered(t_hexagon_grid *grid, GContext *context){
+    GBitmap *framebuffer;
+    uint8_t *data;
+    uint16_t bytes_per_row;
+    GSize size;
+    const uint8_t *fill;
+    const uint8_t *border;
+    t_hexagon *hexagon;
+    GPoint origin;
+    int16_t i, row, y;
+    uint8_t *line;
+
+    framebuffer = graphics_capture_frame_buffer(context);
+    if( !framebuffer )
+        return;
+
+    data = gbitmap_get_data(framebuffer);
+    bytes_per_row = gbitmap_get_bytes_per_row(framebuffer);
+    size = gbitmap_get_bounds(framebuffer).size;
+    border = hexagon_dither_pattern(grid->border_color);
+
+    for(i = 0; i < grid->nb_hexagons; i++){
+        hexagon = &grid->hexagons[i];
+        if( !hexagon_is_visible(grid, hexagon) )
+            continue;
+
+        origin = hexagon_get_draw_origin(grid, hexagon);
+        fill = hexagon_dither_pattern(hexagon->color);
+
+        for(row = 0; row < grid->height; row++){
+            y = origin.y + row;
+            if( y < 0 || y >= size.h )
+                continue;
+
+            line = data + y * bytes_per_row;
+            hexagon_fill_row(line,
+                             origin.x + grid->raster->spans[row].left,
+                             origin.x + grid->raster->spans[row].right,
+                             size.w, fill[y & 3]);
+            if( grid->border_width ){
+                hexagon_fill_row(line,
+                                 origin.x + grid->raster->border_outer_spans[row].left,
+                                 origin.x + grid->raster->border_outer_spans[row].right,
+                                 size.w, border[y & 3]);
+                hexagon_fill_row(line,
+                                 origin.x + grid->raster->border_inner_spans[row].left,
+                                 origin.x + grid->raster->border_inner_spans[row].right,
+                                 size.w, fill[y & 3]);
+            }
+        }
+    }
+
+    graphics_release_frame_buffer(context, framebuffer);
+}
+#elif !HEXAGON_PALETTE_BANDS && !HEXAGON_FRAMEBUFFER_SPANS
+static void hexagon_grid_draw_paths(t_hexagon_grid *grid, GContext *context){
+    t_hexagon *hexagon;
+    GPoint origin;
+    int16_t i;
+
+    if( grid->border_width ){
+        graphics_context_set_stroke_color(context, grid->border_color);
+        graphics_context_set_stroke_width(context, (uint8_t)grid->border_width);
+    }
+
+    for(i = 0; i < grid->nb_hexagons; i++){
+        hexagon = &grid->hexagons[i];
+        if( !hexagon_is_visible(grid, hexagon) )
+            continue;
+
+        origin = hexagon_get_draw_origin(grid, hexagon);
+
+        graphics_context_set_fill_color(context, hexagon->color);
+        gpath_move_to(grid->path, origin);
+        gpath_draw_filled(context, grid->path);
+
+        if( grid->border_width ){
+            gpath_move_to(grid->border_path, origin);
+            gpath_draw_outline(context, grid->border_path);
+        }
+    }
+}
+#endif
+
+#if HEXAGON_AA_SPANS
+/* Blend of two 2 bit color channels, s_blend[top][bottom][coverage of top] */
+static uint8_t s_blend[4][4][HEXAGON_COVERAGE_LEVELS];
+
+static void hexagon_init_blend_table(){
+    int16_t top, bottom, level;
+
+    for(top = 0; top < 4; top++)
+        for(bottom = 0; bottom < 4; bottom++)
+            for(level = 0; level < HEXAGON_COVERAGE_LEVELS; level++)
+                s_blend[top][bottom][level] =
+                    (top * level + bottom * (HEXAGON_COVERAGE_LEVELS - 1 - level) +
+                     (HEXAGON_COVERAGE_LEVELS - 1) / 2) / (HEXAGON_COVERAGE_LEVELS - 1);
+}
+
+static uint8_t hexagon_blend(GColor top, uint8_t bottom_argb, uint8_t level){
+    GColor bottom = (GColor){ .argb = bottom_argb };
+
+    return (GColor){ .a = 3,
+                     .r = s_blend[top.r][bottom.r][level],
+                     .g = s_blend[top.g][bottom.g][level],
+                     .b = s_blend[top.b][bottom.b][level] }.argb;
+}
+#endif
+
+#if HEXAGON_FRAMEBUFFER_SPANS
+
+/**
+ * @brief Fills a span of an 8 bit framebuffer row. With the antialiasing, the
+ * pixels on both sides of it are blended with their coverage.
+ */
+static void hexagon_fill_row_8bit(uint8_t *row, int16_t origin_x,
+                                  const t_hexagon_span *span,
+                                  int16_t width, GColor color){
+    int16_t x0 = origin_x + span->left;
+    int16_t x1 = origin_x + span->right;
+    int16_t x;
+
+    if( x0 > x1 )
+        return;
+
+#if HEXAGON_AA_SPANS
+    if( span->coverage ){
+        if( x0 - 1 >= 0 && x0 - 1 < width )
+            row[x0 - 1] = hexagon_blend(color, row[x0 - 1], span->coverage);
+        if( x1 + 1 >= 0 && x1 + 1 < width )
+            row[x1 + 1] = hexagon_blend(color, row[x1 + 1], span->coverage);
+    }
+#endif
+
+    if( x0 < 0 )
+        x0 = 0;
+    if( x1 >= width )
+        x1 = width - 1;
+    for(x = x0; x <= x1; x++)
+        row[x] = color.argb;
+}
+
+/**
+ * @brief Draws the hexagons directly in the 8 bit framebuffer, a few span
+ * fills per row instead of a GPath fill per hexagon. The grid layer must be
+ * at the origin of the screen.
+ */
+static void hexagon_grid_draw_framebuffer(t_hexagon_grid *grid, GContext *context){
+    GBitmap *framebuffer;
+    uint8_t *data;
+    uint16_t bytes_per_row;
+    GSize size;
+    t_hexagon *hexagon;
+    GPoint origin;
+    int16_t i, row, y;
+    uint8_t *line;
+
+    framebuffer = graphics_capture_frame_buffer(context);
+    if( !framebuffer )
+        return;
+
+    data = gbitmap_get_data(framebuffer);
+    bytes_per_row = gbitmap_get_bytes_per_row(framebuffer);
+    size = gbitmap_get_bounds(framebuffer).size;
+
+    for(i = 0; i < grid->nb_hexagons; i++){
+        hexagon = &grid->hexagons[i];
+        if( !hexagon_is_visible(grid, hexagon) )
+            continue;
+
+        origin = hexagon_get_draw_origin(grid, hexagon);
+
+        for(row = 0; row < grid->height; row++){
+            y = origin.y + row;
+            if( y < 0 || y >= size.h )
+                continue;
+
+            line = data + y * bytes_per_row;
+            hexagon_fill_row_8bit(line, origin.x, &grid->raster->spans[row],
+                                  size.w, hexagon->color);
+            if( grid->border_width ){
+                hexagon_fill_row_8bit(line, origin.x, &grid->raster->border_outer_spans[row],
+                                      size.w, grid->border_color);
+                hexagon_fill_row_8bit(line, origin.x, &grid->raster->border_inner_spans[row],
+                                      size.w, hexagon->color);
+            }
+        }
+    }
+
+    graphics_release_frame_buffer(context, framebuffer);
+}
+#endif
+
+#if HEXAGON_PALETTE_BANDS
+/**
+ * @brief Counts the hexagons crossing the rows y0 to y1 - 1
+ */
+static int16_t hexagon_grid_count_in_rows(t_hexagon_grid *grid, int16_t y0, int16_t y1){
+    int16_t i, count = 0;
+    for(i = 0; i < grid->nb_hexagons; i++){
+        if( grid->hexagons[i].origin.y < y1 &&
+            grid->hexagons[i].origin.y + grid->height > y0 )
+            count++;
+    }
+    return count;
+}
+
+/**
+ * @brief returns the end of the band starting at y0 : the band is made as
+ * tall as possible while its hexagons fit in the palette.
+ */
+static int16_t hexagon_grid_band_end(t_hexagon_grid *grid, int16_t y0, int16_t height){
+    int16_t y1 = y0 + 1;
+
+    while( y1 < height &&
+           hexagon_grid_count_in_rows(grid, y0, y1 + 1) <= BAND_NB_SLOTS - BAND_FIRST_SLOT )
+        y1++;
+    return y1;
+}
+
+/**
+ * @brief Sets the pixels x0 to x1 of a 4 bit bitmap row to the palette slot.
+ * The leftmost pixel is in the most significant bits.
+ */
+static void hexagon_fill_row_4bit(uint8_t *row, int16_t x0, int16_t x1,
+                                  int16_t width, uint8_t slot){
+    int16_t x;
+
+    if( x0 < 0 )
+        x0 = 0;
+    if( x1 >= width )
+        x1 = width - 1;
+
+    for(x = x0; x <= x1; x++){
+        if( x & 1 )
+            row[x >> 1] = (row[x >> 1] & 0xF0) | slot;
+        else
+            row[x >> 1] = (row[x >> 1] & 0x0F) | (slot << 4);
+    }
+}
+
+/**
+ * @brief Rasterizes the hexagons crossing a band, each with its own slot
+ */
+static void hexagon_grid_rasterize_band(t_hexagon_grid *grid, t_hexagon_band *band){
+    uint8_t *data = gbitmap_get_data(band->bitmap);
+    uint16_t bytes_per_row = gbitmap_get_bytes_per_row(band->bitmap);
+    GSize size = gbitmap_get_bounds(band->bitmap).size;
+    uint8_t next_slot = BAND_FIRST_SLOT;
+    t_hexagon *hexagon;
+    uint8_t slot;
+    uint8_t *line;
+    int16_t i, row, y;
+
+    memset(data, 0, bytes_per_row * size.h);
+    band->palette[BAND_SLOT_CLEAR] = GColorClear;
+    band->palette[BAND_SLOT_BORDER] = grid->border_color;
+
+    for(i = 0; i < grid->nb_hexagons; i++){
+        hexagon = &grid->hexagons[i];
+        if( hexagon->origin.y >= band->y + size.h ||
+            hexagon->origin.y + grid->height <= band->y ||
+            next_slot >= BAND_NB_SLOTS )
+            continue;
+
+        slot = next_slot++;
+        band->slots[i] = slot;
+        band->palette[slot] = hexagon->color;
+
+        for(row = 0; row < grid->height; row++){
+            y = hexagon->origin.y + row - band->y;
+            if( y < 0 || y >= size.h )
+                continue;
+
+            line = data + y * bytes_per_row;
+            hexagon_fill_row_4bit(line,
+                                  hexagon->origin.x + grid->raster->spans[row].left,
+                                  hexagon->origin.x + grid->raster->spans[row].right,
+                                  size.w, slot);
+            if( grid->border_width ){
+                hexagon_fill_row_4bit(line,
+                                      hexagon->origin.x + grid->raster->border_outer_spans[row].left,
+                                      hexagon->origin.x + grid->raster->border_outer_spans[row].right,
+                                      size.w, BAND_SLOT_BORDER);
+                hexagon_fill_row_4bit(line,
+                                      hexagon->origin.x + grid->raster->border_inner_spans[row].left,
+                                      hexagon->origin.x + grid->raster->border_inner_spans[row].right,
+                                      size.w, slot);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Splits the grid in bands and rasterizes them. This is only done once,
+ * colors changes are then palette writes.
+ * @return false when a single row crosses more hexagons than a palette holds,
+ * no band is built then.
+ */
+static bool hexagon_grid_build_bands(t_hexagon_grid *grid){
+    GSize size = layer_get_bounds(grid->layer).size;
+    t_hexagon_band *band;
+    int16_t y0, y1, i;
+
+    grid->raster->nb_bands = 0;
+    for(y0 = 0; y0 < size.h; y0 = y1){
+        y1 = hexagon_grid_band_end(grid, y0, size.h);
+        if( hexagon_grid_count_in_rows(grid, y0, y1) > BAND_NB_SLOTS - BAND_FIRST_SLOT ){
+            APP_LOG(APP_LOG_LEVEL_ERROR, "%d hexagons on row %d, more than a palette holds",
+                    hexagon_grid_count_in_rows(grid, y0, y1), y0);
+            grid->raster->nb_bands = 0;
+            grid->raster->bands_overflow = true;
+            return false;
+        }
+        grid->raster->nb_bands++;
+    }
+
+    grid->raster->bands = malloc( grid->raster->nb_bands * sizeof( t_hexagon_band ) );
 
-static struct _hexagon_layer_data *hexagon_get_layer_data(Layer *layer){
-    struct _hexagon_layer_data *layer_data = layer_get_data( layer );
-    return layer_data;
+    for(i = 0, y0 = 0; i < grid->raster->nb_bands; i++, y0 = y1){
+        y1 = hexagon_grid_band_end(grid, y0, size.h);
+        band = &grid->raster->bands[i];
+
+        band->y = y0;
+        band->palette = malloc( BAND_NB_SLOTS * sizeof( GColor ) );
+        memset( band->palette, 0, BAND_NB_SLOTS * sizeof( GColor ) );
+        band->slots = malloc( grid->max_hexagons );
+        memset( band->slots, 0, grid->max_hexagons );
+        band->bitmap = gbitmap_create_blank_with_palette(GSize(size.w, y1 - y0),
+                                                         GBitmapFormat4BitPalette,
+                                                         band->palette,
+                                                         false);
+        hexagon_grid_rasterize_band(grid, band);
+    }
+    return true;
+}
+
+static void hexagon_grid_destroy_bands(t_hexagon_grid *grid){
+    int16_t i;
+
+    for(i = 0; i < grid->raster->nb_bands; i++){
+        gbitmap_destroy(grid->raster->bands[i].bitmap);
+        free(grid->raster->bands[i].palette);
+        free(grid->raster->bands[i].slots);
+    }
+    free(grid->raster->bands);
+    grid->raster->bands = NULL;
+    grid->raster->nb_bands = 0;
+    grid->raster->bands_overflow = false;
+}
+
+/**
+ * @brief Recolors an hexagon by rewriting its palette slot in each band
+ */
+static void hexagon_set_band_color(t_hexagon *hexagon, GColor color){
+    t_hexagon_grid *grid = hexagon->grid;
+    int16_t index = hexagon - grid->hexagons;
+    int16_t i;
+
+    for(i = 0; i < grid->raster->nb_bands; i++){
+        if( grid->raster->bands[i].slots[index] )
+            grid->raster->bands[i].palette[grid->raster->bands[i].slots[index]] = color;
+    }
+}
+
+/**
+ * @brief Draws the bands, building them first if needed
+ * @return false if the grid can not be split in bands, or if it is squeezed in
+ * a smaller visible height. Nothing is drawn then.
+ */
+static bool hexagon_grid_draw_bands(t_hexagon_grid *grid, GContext *context){
+    t_hexagon_band *band;
+    GRect frame;
+    int16_t i;
+
+    /* The bands are rasterized with the hexagons at their initial place */
+    if( grid->raster->bands_overflow || grid->visible_height != grid->full_height )
+        return false;
+    if( !grid->raster->bands && !hexagon_grid_build_bands(grid) )
+        return false;
+
+    graphics_context_set_compositing_mode(context, GCompOpSet);
+    for(i = 0; i < grid->raster->nb_bands; i++){
+        band = &grid->raster->bands[i];
+        frame = gbitmap_get_bounds(band->bitmap);
+        frame.origin.y = band->y;
+        graphics_draw_bitmap_in_rect(context, band->bitmap, frame);
+    }
+    graphics_context_set_compositing_mode(context, GCompOpAssign);
+    return true;
 }
+#endif
+
+static void hexagon_grid_update_proc( Layer *layer, GContext *context ){
+    t_hexagon_grid *grid = hexagon_grid_get_layer_data(layer);
+    t_hexagon *hexagon;
+    GPoint origin;
+    int16_t i;
 
-static void hexagon_update_proc( Layer *layer, GContext *context ){
-    struct _hexagon_layer_data *layer_data = hexagon_get_layer_data(layer);
-        
-    graphics_context_set_fill_color(context, layer_data->color);
-    gpath_draw_filled(context, layer_data->path);
-    
-    if( layer_data->border_path ){
-        graphics_context_set_stroke_color(context, layer_data->border_color);
-        graphics_context_set_stroke_width(context,(uint8_t)layer_data->border_width);
-        gpath_draw_outline(context, layer_data->border_path);
+#if defined(PBL_BW)
+    hexagon_grid_draw_dithered(grid, context);
+#elif HEXAGON_PALETTE_BANDS
+    if( !hexagon_grid_draw_bands(grid, context) )
+        hexagon_grid_draw_framebuffer(grid, context);
+#elif HEXAGON_FRAMEBUFFER_SPANS
+    hexagon_grid_draw_framebuffer(grid, context);
+#else
+    hexagon_grid_draw_paths(grid, context);
+#endif
+
+    for(i = 0; i < grid->nb_hexagons; i++){
+        hexagon = &grid->hexagons[i];
+        if( !hexagon->text || !hexagon_is_visible(grid, hexagon) )
+            continue;
+
+        origin = hexagon_get_draw_origin(grid, hexagon);
+        hexagon_draw_label(context, hexagon->text, origin);
+        hexagon_draw_label(context, hexagon->legend, origin);
     }
-    
 }
 
-static GPoint *create_hexagonal_path(int16_t side_width){
-    GPoint *points = malloc(6 * sizeof(GPoint));
+/**
+ * @brief Measures the label text, and shrinks the drawing box around it so that
+ * the layout work is only done here, when the text changes.
+ * @param label
+ */
+static void hexagon_label_layout( t_hexagon_label *label ){
+    GSize size = graphics_text_layout_get_content_size(label->text,
+                                                       label->font,
+                                                       label->frame,
+                                                       GTextOverflowModeWordWrap,
+                                                       GTextAlignmentCenter);
+    /* Keep a pixel of slack on each side, so that the text never wraps */
+    size.w += 2;
+    if( size.w > label->frame.size.w )
+        size.w = label->frame.size.w;
+
+    label->box = GRect(label->frame.origin.x + (label->frame.size.w - size.w) / 2,
+                       label->frame.origin.y,
+                       size.w,
+                       label->frame.size.h);
+}
+
+static t_hexagon_label *hexagon_create_label( GRect frame,
+                                              GColor color,
+                                              const char *text,
+                                              GFont font ){
+    t_hexagon_label *label = malloc( sizeof( t_hexagon_label ) );
+    memset( label, 0, sizeof(t_hexagon_label) );
+
+    label->frame = frame;
+    label->color = color;
+    label->font = font;
+    strncpy(label->text, text, HEXAGON_LABEL_SIZE - 1);
+    hexagon_label_layout(label);
+
+    return label;
+}
+
+static void create_hexagonal_path(GPoint *points, int16_t side_width){
     int16_t hexagon_half_height;
-    
+
     hexagon_half_height = HEX_HEIGHT(side_width);
     /* Left */
     points[0].x = 0;
     points[0].y = hexagon_half_height;
-    
+
     /* Up left*/
     points[1].x = (side_width / 2);
     points[1].y = 0;
-    
+
     /* Up right*/
     points[2].x = side_width + (side_width / 2);
     points[2].y = 0;
-    
+
     /* Right */
     points[3].x = side_width * 2;
     points[3].y = hexagon_half_height;
-    
+
     /* Down right*/
     points[4].x = side_width + (side_width / 2);
     points[4].y = hexagon_half_height * 2;
-    
+
      /* Down left*/
     points[5].x = (side_width / 2);
     points[5].y = hexagon_half_height * 2;
-    
-    return points;
+}
 
+#if HEXAGON_SOFTWARE_SPANS
+/**
+ * @brief Computes the rows of the hexagons and of their border, used to fill
+ * them without going through GPath
+ * @param grid
+ * @param border_side_width
+ */
+static void hexagon_grid_compute_spans(t_hexagon_grid *grid, int16_t border_side_width){
+    int16_t side_width = grid->side_width;
+    int16_t half_height = HEX_HEIGHT(side_width);
+    int16_t border_half_height = HEX_HEIGHT(border_side_width);
+    int16_t offset = side_width - border_side_width;
+    float border_size = grid->border_width;
+
+    grid->raster = malloc( sizeof( struct _hexagon_raster ) +
+                           3 * grid->height * sizeof( t_hexagon_span ) );
+    memset( grid->raster, 0, sizeof( struct _hexagon_raster ) );
+    grid->raster->spans = (t_hexagon_span *)(grid->raster + 1);
+    grid->raster->border_outer_spans = grid->raster->spans + grid->height;
+    grid->raster->border_inner_spans = grid->raster->spans + 2 * grid->height;
+
+    hexagon_compute_spans(grid->raster->spans, grid->height,
+                          side_width, half_height,
+                          side_width, half_height);
+
+    /* The border line is centered on the border path */
+    hexagon_compute_spans(grid->raster->border_outer_spans, grid->height,
+                          offset + border_side_width,
+                          offset - 1 + border_half_height,
+                          border_side_width + border_size / (2 * HALF_SQRT_3),
+                          border_half_height + border_size / 2);
+    hexagon_compute_spans(grid->raster->border_inner_spans, grid->height,
+                          offset + border_side_width,
+                          offset - 1 + border_half_height,
+                          border_side_width - border_size / (2 * HALF_SQRT_3),
+                          border_half_height - border_size / 2);
 }
-t_hexagon *create_hexagon_with_border(GPoint center, 
-                                      int16_t side_width,
-                                      GColor color,
-                                      int16_t border_side_width,
-                                      GColor border_color,
-                                      int16_t border_size,
-                                      Layer *parent_layer){
+#endif
+
+t_hexagon_grid *create_hexagon_grid(int16_t max_hexagons,
+                                    int16_t side_width,
+                                    int16_t border_side_width,
+                                    GColor border_color,
+                                    int16_t border_size,
+                                    Layer *parent_layer){
+    t_hexagon_grid *grid;
+    int16_t half_height;
     int i;
     int offset;
-    t_hexagon * hexagon = create_hexagon(center, side_width, color, parent_layer);
-    
-    struct _hexagon_layer_data *layer_data= hexagon_get_layer_data( hexagon->layer );
-    
-    GPoint *points = create_hexagonal_path( border_side_width );
-    
-    GPathInfo border_path_info = {
+
+    grid = malloc( sizeof( t_hexagon_grid ) );
+    memset( grid, 0, sizeof(t_hexagon_grid) );
+
+    grid->hexagons = malloc( max_hexagons * sizeof( t_hexagon ) );
+    memset( grid->hexagons, 0, max_hexagons * sizeof( t_hexagon ) );
+    grid->max_hexagons = max_hexagons;
+
+    half_height = HEX_HEIGHT(side_width);
+    grid->side_width = side_width;
+    grid->height = half_height * 2 + 1;
+    grid->border_color = border_color;
+    grid->border_width = border_size;
+
+    /* The geometry is shared by all the hexagons, and moved before each draw */
+    create_hexagonal_path(grid->points, side_width);
+#if !HEXAGON_SOFTWARE_SPANS
+    grid->path = gpath_create( &(GPathInfo){
         .num_points = 6,
-        .points = points
-    };
-    
+        .points = grid->points
+    });
+#endif
+
+    create_hexagonal_path(grid->border_points, border_side_width);
     //We offset the border to center it.
     offset = side_width - border_side_width;
     for( i=0; i < 6; ++i){
-        points[i].x += offset;
-        points[i].y += (offset-1);
+        grid->border_points[i].x += offset;
+        grid->border_points[i].y += (offset-1);
     }
-    
-    hexagon->border_points = points;
-    
-    layer_data->border_path = gpath_create( &border_path_info );
-    layer_data->border_color = border_color;
-    layer_data->border_width = border_size;
-    
-    return hexagon;
-}
 
-t_hexagon *create_hexagon(GPoint center, 
-                          int16_t side_width, 
-                          GColor color, 
-                          Layer *parent_layer){
-    
-    t_hexagon * hexagon;
-    GPath *path;
-    GPoint *points;  
-    
-    points = create_hexagonal_path(side_width);
-    
-    GPathInfo path_info = {
+#if HEXAGON_SOFTWARE_SPANS
+    /* The spans replace the paths, which are never drawn */
+    hexagon_grid_compute_spans(grid, border_side_width);
+#else
+    grid->border_path = gpath_create( &(GPathInfo){
         .num_points = 6,
-        .points = points
-    };
-    
-    hexagon = malloc( sizeof( t_hexagon ) );
-    memset( hexagon, 0, sizeof(t_hexagon) );
-    
-    hexagon->layer = layer_create_with_data(
-                        GRect(center.x - side_width,
-                              center.y - HEX_HEIGHT(side_width),
-                              side_width * 2,
-                              HEX_HEIGHT(side_width) * 2),
-                        sizeof(struct _hexagon_layer_data));
-    
-    hexagon->center = center;
-    hexagon->side_width = side_width;
-    hexagon->points = points;
-    
-    path = gpath_create( &path_info );
-    
-    struct _hexagon_layer_data *layer_data = hexagon_get_layer_data( hexagon->layer );
-    memset(layer_data,0,sizeof(struct _hexagon_layer_data));
-    
-    layer_data->path = path;
-    layer_data->color = color;
-    
-    layer_set_update_proc( hexagon->layer, hexagon_update_proc );
-    layer_add_child(parent_layer, hexagon->layer);
-    
-    return hexagon;
+        .points = grid->border_points
+    });
+#endif
+
+#if HEXAGON_AA_SPANS
+    hexagon_init_blend_table();
+#endif
+
+    grid->layer = layer_create_with_data(layer_get_bounds(parent_layer),
+                                         sizeof(t_hexagon_grid *));
+    *(t_hexagon_grid **)layer_get_data(grid->layer) = grid;
+    grid->full_height = layer_get_bounds(parent_layer).size.h;
+    grid->visible_height = grid->full_height;
+
+    layer_set_update_proc( grid->layer, hexagon_grid_update_proc );
+    layer_add_child(parent_layer, grid->layer);
+
+    return grid;
 }
 
+void destroy_hexagon_grid(t_hexagon_grid *grid){
+    int16_t i;
+
+    for(i = 0; i < grid->nb_hexagons; i++){
+        free(grid->hexagons[i].legend);
+        free(grid->hexagons[i].text);
+    }
+
+#if !HEXAGON_SOFTWARE_SPANS
+    gpath_destroy( grid->path );
+    gpath_destroy( grid->border_path );
+#endif
+
+#if HEXAGON_PALETTE_BANDS
+    hexagon_grid_destroy_bands(grid);
+#endif
 
-void destroy_hexagon(t_hexagon *hexagon){
-    struct _hexagon_layer_data *layer_data = hexagon_get_layer_data( hexagon->layer );
-    
-    gpath_destroy( layer_data->path );
-    
-    if( layer_data->border_path )
-        gpath_destroy( layer_data->border_path );
-    
-    if(hexagon->legend)
-        text_layer_destroy(hexagon->legend);
-    if( hexagon->text )
-        text_layer_destroy(hexagon->text);
-    
-    layer_destroy( hexagon->layer );
-    free(hexagon->points);
-    free(hexagon->border_points);
-    free( hexagon );
+    layer_destroy( grid->layer );
+    free( grid->raster );
+    free( grid->hexagons );
+    free( grid );
 }
 
-void hexagon_set_color(t_hexagon *hexagon, GColor color){
-    struct _hexagon_layer_data *layer_data = hexagon_get_layer_data( hexagon->layer );
-    layer_data->color = color;
-    layer_mark_dirty(hexagon->layer);
+t_hexagon *hexagon_grid_add(t_hexagon_grid *grid, GPoint center, GColor color){
+    t_hexagon *hexagon;
+
+    if( grid->nb_hexagons >= grid->max_hexagons )
+        return NULL;
+
+    hexagon = &grid->hexagons[grid->nb_hexagons++];
+    hexagon->grid = grid;
+    hexagon->origin = GPoint(center.x - grid->side_width,
+                             center.y - HEX_HEIGHT(grid->side_width));
+    hexagon->color = color;
+
+#if HEXAGON_PALETTE_BANDS
+    /* Rasterized again at the next draw */
+    hexagon_grid_destroy_bands(grid);
+#endif
+
+    layer_mark_dirty(grid->layer);
+    return hexagon;
 }
 
-GColor hexagon_get_color(t_hexagon *hexagon){
-    struct _hexagon_layer_data *layer_data = hexagon_get_layer_data( hexagon->layer );
-    return layer_data->color;
+void hexagon_grid_set_visible_height(t_hexagon_grid *grid, int16_t visible_height){
+    grid->visible_height = visible_height;
+    layer_mark_dirty(grid->layer);
 }
 
-void hexagon_set_border_color(t_hexagon *hexagon, GColor color){
-    struct _hexagon_layer_data *layer_data = hexagon_get_layer_data( hexagon->layer );
-    layer_data->border_color = color;
+int16_t hexagon_grid_get_nb_bands(const t_hexagon_grid *grid){
+#if HEXAGON_PALETTE_BANDS
+    if( grid->raster->bands_overflow )
+        return -1;
+    return grid->raster->nb_bands;
+#else
+    return 0;
+#endif
 }
 
-GColor hexagon_get_border_color(t_hexagon *hexagon){
-    struct _hexagon_layer_data *layer_data = hexagon_get_layer_data( hexagon->layer );
-    return layer_data->border_color;
+GBitmap *hexagon_grid_get_band_bitmap(const t_hexagon_grid *grid, int16_t index){
+#if HEXAGON_PALETTE_BANDS
+    if( index >= 0 && index < grid->raster->nb_bands )
+        return grid->raster->bands[index].bitmap;
+#endif
+    return NULL;
 }
 
-void hexagon_init_text_layer(t_hexagon *hexagon,
-        GRect frame, 
-        GColor color, 
-        const char *init_text, 
-        GFont font){
-    
-    TextLayer *layer;
-    layer = text_layer_create(frame);
-    text_layer_set_background_color(layer, GColorClear);
-    text_layer_set_text_color(layer, color);
-    text_layer_set_text(layer, init_text);
+void hexagon_set_color(t_hexagon *hexagon, GColor color){
+    if( gcolor_equal(hexagon->color, color) )
+        return;
+
+    hexagon->color = color;
 
-    text_layer_set_font(layer, font);
-    text_layer_set_text_alignment(layer, GTextAlignmentCenter);
+#if HEXAGON_PALETTE_BANDS
+    hexagon_set_band_color(hexagon, color);
+#endif
 
-    layer_add_child(hexagon->layer, text_layer_get_layer(layer));
-    hexagon->text = layer;
-    
+    layer_mark_dirty(hexagon->grid->layer);
+}
+
+GColor hexagon_get_color(t_hexagon *hexagon){
+    return hexagon->color;
+}
+
+void hexagon_init_text(t_hexagon *hexagon,
+        GRect frame,
+        GColor color,
+        const char *init_text,
+        GFont font){
+
+    hexagon->text = hexagon_create_label(frame, color, init_text, font);
+    layer_mark_dirty(hexagon->grid->layer);
 }
 
 void hexagon_set_text(t_hexagon *hexagon, const char *text){
-    if(hexagon->text)
-        text_layer_set_text(hexagon->text, text);
+    t_hexagon_label *label = hexagon->text;
+
+    if( !label || strncmp(label->text, text, HEXAGON_LABEL_SIZE - 1) == 0 )
+        return;
+
+    strncpy(label->text, text, HEXAGON_LABEL_SIZE - 1);
+    hexagon_label_layout(label);
+    layer_mark_dirty(hexagon->grid->layer);
 }
 
 void hexagon_set_legend(t_hexagon *hexagon, const char *legend_text){
-    
+    int16_t side_width = hexagon->grid->side_width;
+
     if( !hexagon->text )
         return;
-    
-    TextLayer *layer;
-    layer = text_layer_create(
+
+    hexagon->legend = hexagon_create_label(
             GRect(
                 0,
-                HALF_SQRT_3 * 1.1 * hexagon->side_width, 
-                2*hexagon->side_width, 
-                HALF_SQRT_3 * 0.9 * hexagon->side_width));
-    text_layer_set_background_color(layer, GColorClear);
-    text_layer_set_text_color(layer, hexagon_get_border_color(hexagon)); 
-    text_layer_set_text(layer, legend_text);
-
-    text_layer_set_font(layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
-    text_layer_set_text_alignment(layer, GTextAlignmentCenter);
-  //  layer_set_hidden(text_layer_get_layer(layer), true);
-    layer_add_child(hexagon->layer, text_layer_get_layer(layer));
-    hexagon->legend = layer;
+                HALF_SQRT_3 * 1.1 * side_width,
+                2*side_width,
+                HALF_SQRT_3 * 0.9 * side_width),
+            hexagon->grid->border_color,
+            legend_text,
+            fonts_get_system_font(FONT_KEY_GOTHIC_14));
+    layer_mark_dirty(hexagon->grid->layer);
 }
 
 void hexagon_show_legend(t_hexagon *hexagon){
-    if(hexagon->legend)
-        layer_set_hidden(text_layer_get_layer(hexagon->legend), false);
+    if(hexagon->legend && hexagon->legend->hidden){
+        hexagon->legend->hidden = false;
+        layer_mark_dirty(hexagon->grid->layer);
+    }
 }
 void hexagon_hide_legend(t_hexagon *hexagon){
-    if(hexagon->legend)
-        layer_set_hidden(text_layer_get_layer(hexagon->legend), true);
-}
\ No newline at end of file
+    if(hexagon->legend && !hexagon->legend->hidden){
+        hexagon->legend->hidden = true;
+        layer_mark_dirty(hexagon->grid->layer);
+    }
+}
@@ -1,4 +1,4 @@
-/* 
+/*
  *   Copyright (C) 2015 Maxime Chevallier
  *
  *   This program is free software; you can redistribute it and/or modify
@@ -25,43 +25,139 @@
 
 #define HALF_SQRT_3 ((float)0.86602540378)
 
+/* Set to 1 to rasterize the grid once into palette bitmaps, recoloring an
+ * hexagon then only rewrites its palette entries. Color platforms only. A
+ * grid with more than 14 hexagons on a row is drawn in the framebuffer.
+ * The bitmaps cover the screen : the standard grid takes 13.9 KB of heap
+ * instead of 1.6 KB, and frames are about 2.5 times slower than with
+ * HEXAGON_FRAMEBUFFER_RENDERING in the host benchmark. */
+#ifndef HEXAGON_PALETTE_RENDERING
+#define HEXAGON_PALETTE_RENDERING 0
+#endif
+
+/* Set to 1 to draw the slanted edges antialiased, from precomputed coverage
+ * tables. Color platforms only, ignored with the palette rendering. Frames
+ * are 1.5 to 2 times slower than with HEXAGON_FRAMEBUFFER_RENDERING in the
+ * host benchmark, and take no more heap : the blend table is static. */
+#ifndef HEXAGON_ANTIALIASING
+#define HEXAGON_ANTIALIASING 0
+#endif
+
+/* Set to 1 to fill the hexagons row by row in the framebuffer instead of with
+ * GPath, for grids of many small hexagons. Color platforms only, always on
+ * with the antialiasing. */
+#ifndef HEXAGON_FRAMEBUFFER_RENDERING
+#define HEXAGON_FRAMEBUFFER_RENDERING 0
+#endif
+
+/* Longest label, including the trailing '\0'. Labels are UTF-8. */
+#define HEXAGON_LABEL_SIZE 8
+
+/**
+ * A text drawn directly by the hexagon layer. The drawing box is measured
+ * once per text change, redraws only call graphics_draw_text.
+ */
+typedef struct{
+    char text[HEXAGON_LABEL_SIZE];
+    GFont font;
+    GColor color;
+    GRect frame;
+    GRect box;
+    bool hidden;
+} t_hexagon_label;
+
+typedef struct _hexagon_grid t_hexagon_grid;
+
 typedef struct{
+    t_hexagon_grid *grid;
+    /* Top left corner of the hexagon, relative to the parent layer */
+    GPoint origin;
+    GColor color;
+    t_hexagon_label *text;
+    t_hexagon_label *legend;
+} t_hexagon;
+
+/**
+ * All the hexagons of a grid share the same size, the same geometry and a
+ * single layer, which draws them all.
+ */
+struct _hexagon_grid{
     Layer *layer;
-    GPoint center;
-    GPoint *points;
-    GPoint *border_points;
+    t_hexagon *hexagons;
+    int16_t nb_hexagons;
+    int16_t max_hexagons;
     int16_t side_width;
-    TextLayer *text;
-    TextLayer *legend;
-} t_hexagon;
+    int16_t height;
+    GPoint points[6];
+    GPoint border_points[6];
+    GPath *path;
+    GPath *border_path;
+    GColor border_color;
+    int16_t border_width;
+    /* Height of the parent layer, and of its part that is not obstructed */
+    int16_t full_height;
+    int16_t visible_height;
+    /* Spans and palette bands, private to hexagon.c. NULL with GPath. */
+    struct _hexagon_raster *raster;
+};
+
+/**
+ * @brief Creates an empty grid of hexagons on the heap. Its layer covers the
+ * whole parent layer.
+ * @param max_hexagons the number of hexagons the grid can hold
+ * @param side_width the width of each side of the hexagons
+ * @param border_side_width the side width of the border drawn inside each
+ *        hexagon
+ * @param border_color
+ * @param border_size the width of the border line
+ * @param parent_layer
+ * @return The newly allocated grid
+ */
+t_hexagon_grid *create_hexagon_grid(int16_t max_hexagons,
+                                    int16_t side_width,
+                                    int16_t border_side_width,
+                                    GColor border_color,
+                                    int16_t border_size,
+                                    Layer *parent_layer);
 
 /**
- * @brief Creates an hexagon on the heap.
- * @param center the coordinates of the center of the hexagon, relative to the 
+ * @brief Free the memory used by the grid and all its hexagons
+ * @param grid
+ */
+void destroy_hexagon_grid(t_hexagon_grid *grid);
+
+/**
+ * @brief Adds an hexagon to the grid.
+ * @param grid
+ * @param center the coordinates of the center of the hexagon, relative to the
  *        parent layer
- * @param side_width the width of each side of the hexagon
  * @param color the fill color
- * @param parent_layer the parent layer of the hexagon
- * @return The newly allocated hexagon
+ * @return The new hexagon, owned by the grid
  */
-t_hexagon *create_hexagon(GPoint center, 
-                          int16_t side_width, 
-                          GColor color, 
-                          Layer *parent_layer);
-
-t_hexagon *create_hexagon_with_border(GPoint center, 
-                                      int16_t side_width,
-                                      GColor color,
-                                      int16_t border_side_width,
-                                      GColor border_color,
-                                      int16_t border_size,
-                                      Layer *parent_layer);
+t_hexagon *hexagon_grid_add(t_hexagon_grid *grid, GPoint center, GColor color);
 
 /**
- * Free the memory used by the hexagon
- * @param hexagon
+ * @brief Fits the grid in the top visible_height pixels of its layer. The
+ * vertical distance between the centers is scaled, the hexagons keep their
+ * size and overlap, and their labels stay on top. The hexagons that are
+ * completely outside of the visible area are not drawn.
+ * @param grid
+ * @param visible_height height of the visible area of the parent layer
  */
-void destroy_hexagon(t_hexagon *hexagon);
+void hexagon_grid_set_visible_height(t_hexagon_grid *grid, int16_t visible_height);
+
+/**
+ * @brief Number of palette bands of the grid, built at its first draw
+ * @return 0 before the first draw or without HEXAGON_PALETTE_RENDERING, -1
+ * when a row holds too many hexagons and the grid is drawn without bands
+ */
+int16_t hexagon_grid_get_nb_bands(const t_hexagon_grid *grid);
+
+/**
+ * @brief returns the 4 bit palette bitmap of a band, NULL if there is no such
+ * band
+ */
+GBitmap *hexagon_grid_get_band_bitmap(const t_hexagon_grid *grid, int16_t index);
 
 /**
  * @brief Sets the color of the hexagon
@@ -72,25 +168,38 @@ void hexagon_set_color(t_hexagon *hexagon, GColor color);
 /**
  * @brief returns the current color of the hexagon
  * @param hexagon
- * @return 
+ * @return
  */
 GColor hexagon_get_color(t_hexagon *hexagon);
 
 /**
- * @brief initializes the text layer of an hexagon
+ * @brief initializes the text of an hexagon. The text is drawn by the
+ * hexagon itself, no layer is created.
  * @param hexagon
- * @param frame
+ * @param frame the text frame, relative to the hexagon
  * @param color
  * @param init_text
  * @param font
  */
-void hexagon_init_text_layer(t_hexagon *hexagon,
-        GRect frame, 
-        GColor color, 
-        const char *init_text, 
+void hexagon_init_text(t_hexagon *hexagon,
+        GRect frame,
+        GColor color,
+        const char *init_text,
         GFont font);
 
+/**
+ * @brief Sets the text of an hexagon. The text is copied, and the hexagon is
+ * only redrawn when it actually changes.
+ * @param hexagon
+ * @param text
+ */
 void hexagon_set_text(t_hexagon *hexagon, const char *text);
+
+/**
+ * @brief Adds a small legend under the text of an hexagon
+ * @param hexagon
+ * @param legend_text
+ */
 void hexagon_set_legend(t_hexagon *hexagon, const char *legend_text);
 
 void hexagon_show_legend(t_hexagon *hexagon);
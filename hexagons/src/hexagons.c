@@ -21,54 +21,111 @@
 #include <pebble.h>
 
 #include "hexagon.h"
+#include "format.h"
+#include "heatmap.h"
+#include "automaton.h"
+#include "layout.h"
 
 #define COLOR_H  GColorFromRGBA(255,20,0,255)
 #define INITIAL_COLOR GColorBlack
-#define NB_HEXAGONS 18
-#define HEX_DAYNUM 7
-#define HEX_DAY 6
-#define HEX_WEEK 8
-#define HEX_YEAR 15
-#define HEX_BATT 1
-#define HEX_MONTH 0
 
-/* --------------------------- Function signatures ---------------------------*/
+/* Set to 1 to tile the screen with small hexagons, filled as the hour goes by.
+ * On color platforms, it needs HEXAGON_FRAMEBUFFER_RENDERING in hexagon.h, and
+ * not HEXAGON_PALETTE_RENDERING. */
+#define DENSE_MODE 0
+#define DENSE_SIDE 9
+#define DENSE_COLUMNS 12
+#define DENSE_ROWS 13
+#define DENSE_EMPTY_COLOR GColorDarkGray
+
+#if DENSE_MODE
+#define NB_HEXAGONS (DENSE_COLUMNS * DENSE_ROWS)
+#else
+#define NB_HEXAGONS LAYOUT_STANDARD_HEXAGONS
+#endif
+#define TIME_Y 72
+
+/* Set to 1 to color the hexagons without text with the steps of the last hours.
+ * The step counts also need "capabilities": ["health"] in appinfo.json. */
+#define HEATMAP_MODE 0
+
+/* Set to 1 to run an hexagonal game of life on the grid between two color changes */
+#define AUTOMATON_MODE 0
+#define AUTOMATON_PERIOD 500
+#define AUTOMATON_MAX_GENERATIONS 40
+
+#define SWEEP_DURATION 1500
+#define LEGEND_DURATION 1000
+/* The sweep never wakes up more often than the display can refresh */
+#define MIN_FRAME_INTERVAL 33
+
+#if DENSE_MODE && (HEATMAP_MODE || AUTOMATON_MODE)
+#error "The heatmap and the automaton need the standard layout"
+#endif
+
+/* GPath fills can not keep up. The palette bands can not hold a dense row,
+ * and take more than the basalt heap budget from 72 hexagons on. */
+#if DENSE_MODE && defined(PBL_COLOR) && (HEXAGON_PALETTE_RENDERING || \
+    !(HEXAGON_FRAMEBUFFER_RENDERING || HEXAGON_ANTIALIASING))
+#error "The dense mode needs HEXAGON_FRAMEBUFFER_RENDERING, without HEXAGON_PALETTE_RENDERING"
+#endif
 
-static void init_hexagons(int16_t hexa_size, int16_t hexa_border_size, int16_t border_width, Window *window);
-static void next_color_update_animation(struct Animation *animation, const uint32_t time_normalized);
+/* --------------------------- Function signatures ---------------------------*/
 
-void next_color_animation_started(Animation *animation, void *data);
-void next_color_animation_stopped(Animation *animation, bool finished, void *data);
-static void legend_update_animation(struct Animation *animation, const uint32_t time_normalized);
+static void next_color_step(void *data);
+static void next_color_finished();
 static void display_legend();
 
 
 /* --------------- Global variables ------------------------------------------*/
 static Window *g_main_window;
+static t_hexagon_grid * g_grid;
 static t_hexagon * hexs[NB_HEXAGONS];
 static TextLayer * g_hour_layer;
 static TextLayer * g_minute_layer;
 
 static GFont s_custom_font;
 
-static Animation *g_next_color_animation = NULL;
-static Animation *g_display_legend_animation = NULL;
+static AppTimer *g_next_color_timer = NULL;
+static AppTimer *g_legend_timer = NULL;
+static bool g_legend_displayed = false;
 
 static int16_t g_current_hex;
+static uint32_t g_next_color_start;
 
-static const AnimationImplementation g_alert_impl = {
-    .setup = NULL,
-    .teardown = NULL,
-    .update = (AnimationUpdateImplementation) next_color_update_animation
-};
+static int16_t color_index = 0;
 
-static const    AnimationImplementation legend_impl = {
-        .setup = NULL,
-        .teardown = NULL,
-        .update = (AnimationUpdateImplementation) legend_update_animation
+#if DENSE_MODE
+/* Number of hexagons showing the color, the others show the rest of the hour */
+static int16_t g_dense_filled;
+#endif
+
+#if AUTOMATON_MODE
+static AppTimer *g_automaton_timer = NULL;
+static GColor g_automaton_color;
+static int16_t g_automaton_generation;
+/* False when the layout does not fit in the automaton grid */
+static bool g_automaton_ready = false;
+#endif
+
+#if HEATMAP_MODE
+/* Heatmap slot of each hexagon, -1 for the hexagons showing a text */
+static const int8_t g_heatmap_slot[NB_HEXAGONS] = {
+    -1, -1, 0, 1, 2, 3, -1, -1, -1, 4, 5, 6, 7, 8, 9, -1, 10, 11
 };
 
-static int16_t color_index = 0;
+/** ----------------------------------------------------------------------------
+ * @brief recolors the heatmap hexagons whose slot changed
+ * @param changed mask of the changed slots
+ */
+static void heatmap_apply(uint16_t changed){
+    int16_t i;
+    for(i = 0; i < NB_HEXAGONS; i++){
+        if( g_heatmap_slot[i] >= 0 && (changed & (1 << g_heatmap_slot[i])) )
+            hexagon_set_color(hexs[i], heatmap_get_color(g_heatmap_slot[i]));
+    }
+}
+#endif
 
 /** ----------------------------------------------------------------------------
  * @brief returns the next color to display. Random was an option, but we want to
@@ -91,26 +148,162 @@ static GColor next_color(){
 }
 
 /** ----------------------------------------------------------------------------
- * @brief starts the animation displaying the next color
+ * @brief returns the color the sweep gives to an hexagon
+ * @param hex
  */
-static void display_next_color(){
+static GColor sweep_color(int16_t hex){
+#if DENSE_MODE
+    if( hex >= g_dense_filled )
+        return DENSE_EMPTY_COLOR;
+#endif
+    return next_color();
+}
 
-    /* The var is global, to ensure proper cleanup, but we reuse it for each new
-     * animation */
-    if( g_next_color_animation )
-        animation_destroy(g_next_color_animation);
+#if AUTOMATON_MODE
+/** ----------------------------------------------------------------------------
+ * @brief recolors the hexagons whose state flipped : living hexagons keep the
+ * current color, dead ones go dark.
+ * @param flipped mask of the flipped hexagons
+ */
+static void automaton_apply(uint32_t flipped){
+    uint32_t alive = automaton_get_cells();
+    int16_t i;
 
-    g_next_color_animation= animation_create();
+    for(i = 0; i < NB_HEXAGONS; i++){
+        if( flipped & ((uint32_t)1 << i) )
+            hexagon_set_color(hexs[i], (alive & ((uint32_t)1 << i)) ?
+                                       g_automaton_color : INITIAL_COLOR);
+    }
+}
 
-    animation_set_handlers(g_next_color_animation, (AnimationHandlers) {
-            .started =  next_color_animation_started,
-            .stopped =  next_color_animation_stopped,
-            }, NULL);
+/** ----------------------------------------------------------------------------
+ * @brief computes one generation, and schedules the next one until the grid
+ * is stable or the generation limit is reached.
+ * @param data
+ */
+static void automaton_timer_callback(void *data){
+    uint32_t flipped = automaton_step();
+
+    g_automaton_timer = NULL;
+    automaton_apply(flipped);
+
+    if( flipped && ++g_automaton_generation < AUTOMATON_MAX_GENERATIONS )
+        g_automaton_timer = app_timer_register(AUTOMATON_PERIOD, automaton_timer_callback, NULL);
+}
+
+static void stop_automaton(){
+    if( g_automaton_timer ){
+        app_timer_cancel(g_automaton_timer);
+        g_automaton_timer = NULL;
+    }
+}
+
+/** ----------------------------------------------------------------------------
+ * @brief seeds the automaton once all the hexagons show the same color
+ * @param color the current color of the hexagons
+ */
+static void start_automaton(GColor color){
+    uint32_t all = ((uint32_t)1 << NB_HEXAGONS) - 1;
 
-    animation_set_implementation(g_next_color_animation, &g_alert_impl);
-    animation_set_duration(g_next_color_animation, 1500);
-    animation_set_curve( g_next_color_animation, AnimationCurveLinear );
-    animation_schedule(g_next_color_animation);
+    stop_automaton();
+    g_automaton_color = color;
+    g_automaton_generation = 0;
+
+    automaton_set_cells((((uint32_t)rand() << 15) ^ rand()) & all);
+    automaton_apply(~automaton_get_cells() & all);
+
+    g_automaton_timer = app_timer_register(AUTOMATON_PERIOD, automaton_timer_callback, NULL);
+}
+
+/** ----------------------------------------------------------------------------
+ * @brief maps the hexagons to the automaton. The hexagons showing a text, or
+ * a heatmap, always stay alive.
+ */
+static void init_automaton(){
+    GPoint origins[NB_HEXAGONS];
+    uint32_t pinned = 0;
+    int16_t i;
+
+    for(i = 0; i < NB_HEXAGONS; i++){
+        origins[i] = hexs[i]->origin;
+        if( hexs[i]->text )
+            pinned |= (uint32_t)1 << i;
+#if HEATMAP_MODE
+        if( g_heatmap_slot[i] >= 0 )
+            pinned |= (uint32_t)1 << i;
+#endif
+    }
+
+    g_automaton_ready = automaton_init(origins, NB_HEXAGONS);
+    if( !g_automaton_ready ){
+        APP_LOG(APP_LOG_LEVEL_ERROR, "The hexagons do not fit in the automaton grid");
+        return;
+    }
+    automaton_set_pinned(pinned);
+}
+#endif
+
+/** ----------------------------------------------------------------------------
+ * @brief returns a millisecond timestamp, to schedule the color change steps
+ */
+static uint32_t now_ms(){
+    time_t seconds;
+    uint16_t milliseconds;
+
+    time_ms(&seconds, &milliseconds);
+    return (uint32_t)seconds * 1000 + milliseconds;
+}
+
+/** ----------------------------------------------------------------------------
+ * @brief returns when the hexagon changes color, from the start of the sweep
+ * @param hex
+ */
+static uint32_t next_color_due(int16_t hex){
+    return (uint32_t)(hex + 1) * SWEEP_DURATION / NB_HEXAGONS;
+}
+
+/** ----------------------------------------------------------------------------
+ * @brief returns the first hexagon, from hex on, whose color the sweep
+ * actually changes, NB_HEXAGONS if there is none. The sweep only wakes up for
+ * those, so that each wakeup is a visible change.
+ * @param hex
+ */
+static int16_t next_changing_hex(int16_t hex){
+    for( ; hex < NB_HEXAGONS; hex++){
+#if HEATMAP_MODE
+        /* The heatmap hexagons keep their own color */
+        if( g_heatmap_slot[hex] >= 0 )
+            continue;
+#endif
+        if( !gcolor_equal(hexagon_get_color(hexs[hex]), sweep_color(hex)) )
+            return hex;
+    }
+    return NB_HEXAGONS;
+}
+
+/** ----------------------------------------------------------------------------
+ * @brief starts the sweep displaying the next color. Instead of running an
+ * animation at full frame rate, we only wake up when an hexagon is due.
+ */
+static void display_next_color(){
+
+    /* The var is global, to ensure proper cleanup, but we reuse it for each new
+     * sweep */
+    if( g_next_color_timer )
+        app_timer_cancel(g_next_color_timer);
+
+#if AUTOMATON_MODE
+    stop_automaton();
+#endif
+
+    g_current_hex = next_changing_hex(0);
+    if( g_current_hex >= NB_HEXAGONS ){
+        next_color_finished();
+        return;
+    }
+
+    g_next_color_start = now_ms();
+    g_next_color_timer = app_timer_register(next_color_due(g_current_hex), next_color_step, NULL);
 }
 
 /** ----------------------------------------------------------------------------
@@ -122,47 +315,41 @@ static void update_time() {
 
     static char hour[] = "00";
     static char minute[] = "00";
-    static char month[] = "zzz";
     static char daynum[] = "99";
     static char weeknum[] = "99";
     static char year[] = "99";
-    static char day[] = "zzz";
     static char s_battery_buffer[] = "999";
     
     // Write the current hours and minutes into the buffer
-    if(clock_is_24h_style() == true) {
-        // Use 24 hour format
-        strftime(hour, 3*sizeof(char), "%H", tick_time);
-    } else {
-        // Use 12 hour format
-        strftime(hour, 3*sizeof(char), "%I", tick_time);
-    }
+    format_hour(hour, tick_time, clock_is_24h_style());
 
-    strftime(minute, 3*sizeof(char), "%M", tick_time);
-    strftime(month, 4*sizeof(char), "%b", tick_time );
-    strftime(daynum, 3*sizeof(char), "%d", tick_time );
-    strftime(weeknum, 3*sizeof(char), "%W", tick_time );
-    strftime(year, 3*sizeof(char), "%y", tick_time );
-    strftime(day, 4*sizeof(char), "%a", tick_time );
+    format_two_digits(minute, tick_time->tm_min);
+    format_two_digits(daynum, tick_time->tm_mday);
+    format_two_digits(weeknum, format_iso_week(tick_time));
+    format_two_digits(year, tick_time->tm_year % 100);
 
     BatteryChargeState charge_state = battery_state_service_peek();
     if (charge_state.is_charging) {
-        snprintf(s_battery_buffer, sizeof(s_battery_buffer), "--");
+        strcpy(s_battery_buffer, "--");
     } else {
-        snprintf(s_battery_buffer, sizeof(s_battery_buffer), "%d", charge_state.charge_percent);
+        format_uint(s_battery_buffer, charge_state.charge_percent);
     }
 
     // Display the new texts
     text_layer_set_text(g_hour_layer, hour);
     text_layer_set_text(g_minute_layer, minute);
     
-    
-    hexagon_set_text(hexs[HEX_MONTH], month);
+#if DENSE_MODE
+    /* The last minute of the hour fills the whole screen */
+    g_dense_filled = NB_HEXAGONS * (tick_time->tm_min + 1) / 60;
+#else
+    hexagon_set_text(hexs[HEX_MONTH], format_month_abbr(tick_time));
     hexagon_set_text(hexs[HEX_DAYNUM], daynum);
     hexagon_set_text(hexs[HEX_WEEK], weeknum);
     hexagon_set_text(hexs[HEX_YEAR], year);
-    hexagon_set_text(hexs[HEX_DAY], day);
+    hexagon_set_text(hexs[HEX_DAY], format_day_abbr(tick_time));
     hexagon_set_text(hexs[HEX_BATT], s_battery_buffer);
+#endif
 }
 
 /** ----------------------------------------------------------------------------
@@ -179,6 +366,11 @@ static void tick_handler( struct tm *tick, TimeUnits units_changed ){
     if( units_changed & MINUTE_UNIT )
         display_next_color();
 
+#if HEATMAP_MODE
+    if( units_changed & HOUR_UNIT )
+        heatmap_apply(heatmap_update(time(NULL)));
+#endif
+
 }
 
 /** ----------------------------------------------------------------------------
@@ -211,104 +403,112 @@ static TextLayer *init_text_layer( GRect frame,
 }
 
 /** ----------------------------------------------------------------------------
- * @brief callback called when the color change animation starts
- * @param animation
- * @param data
- */
-void next_color_animation_started(Animation *animation, void *data) {
-
-    g_current_hex = 0;
-}
-
-/** ----------------------------------------------------------------------------
- * @brief called when the color change animation stops
- * @param animation
- * @param finished
- * @param data
+ * @brief called when all the hexagons have changed color
  */
-void next_color_animation_stopped(Animation *animation, bool finished, void *data) {
+static void next_color_finished() {
     g_current_hex = 0;
     update_time();
+
+#if AUTOMATON_MODE
+    if( g_automaton_ready )
+        start_automaton(next_color());
+#endif
+
     if(++color_index > 5)
         color_index = 0;
     
-    /* The first tiem we load the watchface (i.e. when the legend animation is still
-     NULL ), we show the legend.*/
-    if( g_display_legend_animation == NULL )
+    /* The first time we load the watchface, we show the legend.*/
+    if( !g_legend_displayed )
         display_legend();
 }
 
 /** ----------------------------------------------------------------------------
- * @brief callback called by the Animation mechanism of the pebble API.
- * This is where we gradually change the color of the hexagons
- * @param animation
- * @param time_normalized
+ * @brief timer callback of the color change sweep. This is where we gradually
+ * change the color of the hexagons : all the hexagons that are due change
+ * color, then we sleep until the next one is.
+ * @param data
  */
-static void next_color_update_animation(struct Animation *animation, const uint32_t time_normalized){
+static void next_color_step(void *data){
+
+    uint32_t elapsed = now_ms() - g_next_color_start;
+    uint32_t delay;
+
+    g_next_color_timer = NULL;
 
-    uint16_t i;
-    for(i = g_current_hex ; i < time_normalized / ( ANIMATION_NORMALIZED_MAX / NB_HEXAGONS ); i++){
-        if( i < NB_HEXAGONS )
-            hexagon_set_color(hexs[i], next_color());
+    for( ; g_current_hex < NB_HEXAGONS && next_color_due(g_current_hex) <= elapsed;
+           g_current_hex = next_changing_hex(g_current_hex + 1) ){
+        hexagon_set_color(hexs[g_current_hex], sweep_color(g_current_hex));
     }
-    if(i != g_current_hex)
-        g_current_hex = i;
 
-}
-/** ----------------------------------------------------------------------------
- * @brief callback called when the legend animation starts
- * ( shows the legend text on all hexagons )
- * @param animation
- * @param data
- */
-void legend_animation_started(Animation *animation, void *data) {
-    int16_t i;
-    for(i = 0 ; i < NB_HEXAGONS ; i++){
-        hexagon_show_legend(hexs[i]);
+    if( g_current_hex >= NB_HEXAGONS ){
+        next_color_finished();
+        return;
     }
+
+    delay = next_color_due(g_current_hex) - elapsed;
+    if( delay < MIN_FRAME_INTERVAL )
+        delay = MIN_FRAME_INTERVAL;
+    g_next_color_timer = app_timer_register(delay, next_color_step, NULL);
 }
 
 /** ----------------------------------------------------------------------------
- * @brief callback called when the legend animation stops
- * @param animation
- * @param finished
+ * @brief called when the legend has been displayed long enough
  * @param data
  */
-void legend_animation_stopped(Animation *animation, bool finished, void *data) {
+static void hide_legend(void *data) {
     int16_t i;
+
+    g_legend_timer = NULL;
     for(i = 0 ; i < NB_HEXAGONS ; i++){
         hexagon_hide_legend(hexs[i]);
     }
 }
 
 /** ----------------------------------------------------------------------------
- * @brief ;
- * @param animation
- * @param time_normalized
+ * @brief shows the legend text on all hexagons, for LEGEND_DURATION ms
  */
-static void legend_update_animation(struct Animation *animation, const uint32_t time_normalized){
-    ;//do nothing
+static void display_legend(){
+    int16_t i;
+
+    g_legend_displayed = true;
+    for(i = 0 ; i < NB_HEXAGONS ; i++){
+        hexagon_show_legend(hexs[i]);
+    }
+    g_legend_timer = app_timer_register(LEGEND_DURATION, hide_legend, NULL);
 }
 
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
 /** ----------------------------------------------------------------------------
- * 
+ * @brief fits the grid and the time above the timeline peek or a quick view.
+ * The rows get closer to each other, so that no text hexagon leaves the
+ * screen. Hexagons are only moved, the time stays centered between the rows.
  */
-static void display_legend(){
+static void relayout(){
+    Layer *root = window_get_root_layer(g_main_window);
+    int16_t visible_height = layer_get_unobstructed_bounds(root).size.h;
+    int16_t full_height = layer_get_bounds(root).size.h;
+    GRect frame;
 
-    g_display_legend_animation = animation_create();
+    hexagon_grid_set_visible_height(g_grid, visible_height);
 
-    animation_set_handlers(g_display_legend_animation, (AnimationHandlers) {
-            .started =  legend_animation_started,
-            .stopped =  legend_animation_stopped,
-            }, NULL);
+    frame = layer_get_frame(text_layer_get_layer(g_hour_layer));
+    frame.origin.y = (TIME_Y + frame.size.h / 2) * visible_height / full_height - frame.size.h / 2;
+    layer_set_frame(text_layer_get_layer(g_hour_layer), frame);
 
+    frame = layer_get_frame(text_layer_get_layer(g_minute_layer));
+    frame.origin.y = (TIME_Y + frame.size.h / 2) * visible_height / full_height - frame.size.h / 2;
+    layer_set_frame(text_layer_get_layer(g_minute_layer), frame);
+}
 
-    
-    animation_set_implementation(g_display_legend_animation, &legend_impl);
-    animation_set_duration(g_display_legend_animation, 1000);
-    animation_set_curve( g_display_legend_animation, AnimationCurveLinear );
-    animation_schedule(g_display_legend_animation);
+/** ----------------------------------------------------------------------------
+ * @brief called at each step of the unobstructed area animation
+ * @param progress
+ * @param context
+ */
+static void unobstructed_area_change(AnimationProgress progress, void *context){
+    relayout();
 }
+#endif
 
 /** ----------------------------------------------------------------------------
  * 
@@ -316,29 +516,39 @@ static void display_legend(){
  */
 static void main_window_load(Window *window){
 
-    int16_t side = 26;
-    int16_t b_width = 3;
-    
     s_custom_font = fonts_load_custom_font(resource_get_handle(RESOURCE_ID_ROBOTO_BOLD_35));
 
-    init_hexagons(side, side-4, b_width, window);
+#if DENSE_MODE
+    g_grid = layout_create_dense(hexs, DENSE_COLUMNS, DENSE_ROWS, DENSE_SIDE,
+                                 INITIAL_COLOR, window_get_root_layer(window));
+#else
+    g_grid = layout_create_standard(hexs, INITIAL_COLOR, window_get_root_layer(window));
+#endif
+
+    g_hour_layer = init_text_layer( GRect(2, TIME_Y, 58, 50) , GColorWhite, "--", s_custom_font, window_get_root_layer(window) );
+    g_minute_layer = init_text_layer( GRect(3*(144/5), TIME_Y, 58, 50) , GColorWhite, "--", s_custom_font, window_get_root_layer(window) );
+
+#if !DENSE_MODE
+    layout_init_standard_texts(g_grid);
+#endif
+
+    format_init();
 
-    g_hour_layer = init_text_layer( GRect(2, 72, 58, 50) , GColorWhite, "--", s_custom_font, window_get_root_layer(window) );
-    g_minute_layer = init_text_layer( GRect(3*(144/5), 72, 58, 50) , GColorWhite, "--", s_custom_font, window_get_root_layer(window) );
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+    unobstructed_area_service_subscribe((UnobstructedAreaHandlers) {
+            .change = unobstructed_area_change,
+            }, NULL);
+    /* A peek may already be on screen */
+    relayout();
+#endif
 
-    hexagon_init_text_layer(hexs[HEX_MONTH],GRect(0, 5, 52, 40),GColorBlack, "   ", fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
-    hexagon_init_text_layer(hexs[HEX_DAY],GRect(0, 5, 52, 40), GColorBlack, "   ", fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
-    hexagon_init_text_layer(hexs[HEX_DAYNUM],GRect(0, 5, 52, 40), GColorBlack, "   ", fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
-    hexagon_init_text_layer(hexs[HEX_WEEK],GRect(0, 5, 52, 40), GColorBlack, "   ", fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
-    hexagon_init_text_layer(hexs[HEX_YEAR],GRect(0, 5, 52, 40), GColorBlack, "   ", fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
-    hexagon_init_text_layer(hexs[HEX_BATT],GRect(0, 5, 52, 40), GColorBlack, "   ", fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
+#if HEATMAP_MODE
+    heatmap_apply(heatmap_init(time(NULL)));
+#endif
 
-    hexagon_set_legend(hexs[HEX_MONTH], "mon");
-    hexagon_set_legend(hexs[HEX_DAY], "day");
-    hexagon_set_legend(hexs[HEX_DAYNUM], "day");
-    hexagon_set_legend(hexs[HEX_WEEK], "week");
-    hexagon_set_legend(hexs[HEX_YEAR], "year");
-    hexagon_set_legend(hexs[HEX_BATT], "batt");
+#if AUTOMATON_MODE
+    init_automaton();
+#endif
 
     srand(time(NULL));
     color_index = rand() % 6;
@@ -351,18 +561,29 @@ static void main_window_load(Window *window){
  * @param window
  */
 static void main_window_unload(Window *window){
-    int i;
-    for(i = 0; i < 16; i++)
-        destroy_hexagon(hexs[i]);
+
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+    unobstructed_area_service_unsubscribe();
+#endif
+
+#if AUTOMATON_MODE
+    stop_automaton();
+#endif
+
+    destroy_hexagon_grid(g_grid);
 
     text_layer_destroy(g_hour_layer);
     text_layer_destroy(g_minute_layer);
 
-    if(g_next_color_animation)
-        animation_destroy( g_next_color_animation );
-    
-    if( g_display_legend_animation )
-        animation_destroy(g_next_color_animation);
+    if( g_next_color_timer ){
+        app_timer_cancel( g_next_color_timer );
+        g_next_color_timer = NULL;
+    }
+
+    if( g_legend_timer ){
+        app_timer_cancel( g_legend_timer );
+        g_legend_timer = NULL;
+    }
 }
 
 /** ----------------------------------------------------------------------------
@@ -402,121 +623,3 @@ int main(void) {
     app_event_loop();
     deinit();
 }
-
-/** ----------------------------------------------------------------------------
- * @brief This huge function declares all the hexagons that are displayed on the screen.
- * Layout : 
- * 
- *     __    __
- *  __/12\__/11\__
- * /9 \__/8 \__/10\_
- * \__/7 \__/6 \__/
- * /4 \__/ 2\__/5 \_
- * \__/  \__/  \__/
- * /16\__/15\__/3 \_
- * \__/1 \__/0 \__/
- * /14\__/13\__/17\_
- * \__/  \__/  \__/
- * 
- * @param hexa_size
- * @param hexa_border_size
- * @param border_width
- * @param window
- */
-static void init_hexagons(int16_t hexa_size, int16_t hexa_border_size, int16_t border_width, Window *window){
-
-    int16_t base_interval = 144/5;
-
-    hexs[0] = create_hexagon_with_border(
-            GPoint( 4*base_interval, 168 - base_interval * HALF_SQRT_3  ), 
-            hexa_size,
-            INITIAL_COLOR, 
-            hexa_border_size, 
-            GColorBlack, 
-            border_width, 
-            window_get_root_layer(window));
-
-    hexs[1] = create_hexagon_with_border(
-            GPoint( base_interval +2, 168 - base_interval * HALF_SQRT_3  ),
-            hexa_size, INITIAL_COLOR,hexa_border_size, GColorBlack,
-            border_width, window_get_root_layer(window));
-
-    hexs[2] = create_hexagon_with_border(
-            GPoint( 144/2 - 1, 168 - base_interval * HALF_SQRT_3 * 4 ),
-            hexa_size, INITIAL_COLOR, hexa_border_size, GColorBlack,
-            border_width, window_get_root_layer(window));
-
-    hexs[3] = create_hexagon_with_border(
-            GPoint(144 + base_interval/2 - 5, 168 - base_interval * HALF_SQRT_3 * 2  ),
-            hexa_size, INITIAL_COLOR,hexa_border_size, GColorBlack,
-            border_width, window_get_root_layer(window));
-
-    hexs[4] = create_hexagon_with_border(
-            GPoint(-base_interval / 2 + 3, 168 - base_interval * HALF_SQRT_3 * 4 ),
-            hexa_size, INITIAL_COLOR, hexa_border_size, GColorBlack,
-            border_width, window_get_root_layer(window));
-
-    hexs[5] = create_hexagon_with_border(
-            GPoint(144 + base_interval/2 - 5, 168 - base_interval * HALF_SQRT_3 * 4 ),
-            hexa_size, INITIAL_COLOR, hexa_border_size, GColorBlack,
-            border_width, window_get_root_layer(window));
-
-    hexs[6] = create_hexagon_with_border(
-            GPoint( 4*base_interval, 168 - base_interval * HALF_SQRT_3 * 5 + 1),
-            hexa_size, INITIAL_COLOR, hexa_border_size, GColorBlack,
-            border_width, window_get_root_layer(window));
-
-    hexs[7] = create_hexagon_with_border(
-            GPoint( base_interval+2, 168 - base_interval * HALF_SQRT_3 * 5 + 1),
-            hexa_size,INITIAL_COLOR, hexa_border_size, GColorBlack,
-            border_width, window_get_root_layer(window));
-
-    hexs[8] = create_hexagon_with_border(
-            GPoint( 144/2 - 1, 168 - base_interval * HALF_SQRT_3 * 6 ),
-            hexa_size, INITIAL_COLOR,hexa_border_size,  GColorBlack,
-            border_width, window_get_root_layer(window));
-
-    hexs[9] = create_hexagon_with_border(
-            GPoint(-base_interval / 2 + 3, 168 - base_interval * HALF_SQRT_3 * 6 ),
-            hexa_size, INITIAL_COLOR, hexa_border_size, GColorBlack,
-            border_width, window_get_root_layer(window));
-
-    hexs[10] = create_hexagon_with_border(
-            GPoint(144 + base_interval/2 - 5, 168 - base_interval * HALF_SQRT_3 * 6 ),
-            hexa_size,INITIAL_COLOR, hexa_border_size, GColorBlack,
-            border_width, window_get_root_layer(window));
-
-    hexs[11] = create_hexagon_with_border(
-            GPoint( 4*base_interval, -2 ),
-            hexa_size, INITIAL_COLOR, hexa_border_size, GColorBlack,
-            border_width, window_get_root_layer(window));
-
-    hexs[12] = create_hexagon_with_border(
-            GPoint( base_interval+2, -2),
-            hexa_size, INITIAL_COLOR, hexa_border_size, GColorBlack,
-            border_width, window_get_root_layer(window));
-
-    hexs[13] = create_hexagon_with_border(
-            GPoint( 144/2 - 1, 167 ),
-            hexa_size, INITIAL_COLOR, hexa_border_size, GColorBlack,
-            border_width, window_get_root_layer(window));
-
-    hexs[14] = create_hexagon_with_border(
-            GPoint(-base_interval / 2 + 3, 167 ),
-            hexa_size, INITIAL_COLOR, hexa_border_size, GColorBlack,
-            border_width, window_get_root_layer(window));
-
-    hexs[15] = create_hexagon_with_border(
-            GPoint( 144/2 - 1, 168 - base_interval * HALF_SQRT_3 * 2 ),
-            hexa_size, INITIAL_COLOR, hexa_border_size, GColorBlack,
-            border_width, window_get_root_layer(window));
-
-    hexs[16] = create_hexagon_with_border(
-            GPoint(-base_interval / 2 + 3, 168 - base_interval * HALF_SQRT_3 * 2 ),
-            hexa_size, INITIAL_COLOR,  hexa_border_size,  GColorBlack,
-            border_width, window_get_root_layer(window));
-    hexs[17] = create_hexagon_with_border(
-            GPoint(144 + base_interval/2 - 5, 167 ),
-            hexa_size, INITIAL_COLOR, hexa_border_size, GColorBlack,
-            border_width, window_get_root_layer(window));                          
-}
@@ -0,0 +1,124 @@
+/*
+ *   Copyright (C) 2015 Maxime Chevallier
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software Foundation,
+ *   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ *   Layouts of the hexagons on the screen, shared by the watchface and the
+ *   host tests.
+ */
+
+#include <layout.h>
+
+#define STANDARD_SIDE 26
+#define STANDARD_BORDER_SIDE (STANDARD_SIDE - 4)
+#define STANDARD_BORDER_WIDTH 3
+
+/** ----------------------------------------------------------------------------
+ * Standard layout :
+ * 
+ *     __    __
+ *  __/12\__/11\__
+ * /9 \__/8 \__/10\_
+ * \__/7 \__/6 \__/
+ * /4 \__/ 2\__/5 \_
+ * \__/  \__/  \__/
+ * /16\__/15\__/3 \_
+ * \__/1 \__/0 \__/
+ * /14\__/13\__/17\_
+ * \__/  \__/  \__/
+ * 
+ */
+t_hexagon_grid *layout_create_standard(t_hexagon **hexagons, GColor color, Layer *parent_layer){
+    int16_t base_interval = 144/5;
+    GPoint centers[LAYOUT_STANDARD_HEXAGONS] = {
+        GPoint( 4*base_interval, 168 - base_interval * HALF_SQRT_3 ),
+        GPoint( base_interval +2, 168 - base_interval * HALF_SQRT_3 ),
+        GPoint( 144/2 - 1, 168 - base_interval * HALF_SQRT_3 * 4 ),
+        GPoint( 144 + base_interval/2 - 5, 168 - base_interval * HALF_SQRT_3 * 2 ),
+        GPoint( -base_interval / 2 + 3, 168 - base_interval * HALF_SQRT_3 * 4 ),
+        GPoint( 144 + base_interval/2 - 5, 168 - base_interval * HALF_SQRT_3 * 4 ),
+        GPoint( 4*base_interval, 168 - base_interval * HALF_SQRT_3 * 5 + 1 ),
+        GPoint( base_interval+2, 168 - base_interval * HALF_SQRT_3 * 5 + 1 ),
+        GPoint( 144/2 - 1, 168 - base_interval * HALF_SQRT_3 * 6 ),
+        GPoint( -base_interval / 2 + 3, 168 - base_interval * HALF_SQRT_3 * 6 ),
+        GPoint( 144 + base_interval/2 - 5, 168 - base_interval * HALF_SQRT_3 * 6 ),
+        GPoint( 4*base_interval, -2 ),
+        GPoint( base_interval+2, -2 ),
+        GPoint( 144/2 - 1, 167 ),
+        GPoint( -base_interval / 2 + 3, 167 ),
+        GPoint( 144/2 - 1, 168 - base_interval * HALF_SQRT_3 * 2 ),
+        GPoint( -base_interval / 2 + 3, 168 - base_interval * HALF_SQRT_3 * 2 ),
+        GPoint( 144 + base_interval/2 - 5, 167 ),
+    };
+    t_hexagon_grid *grid;
+    t_hexagon *hexagon;
+    int16_t i;
+
+    grid = create_hexagon_grid(LAYOUT_STANDARD_HEXAGONS, STANDARD_SIDE, STANDARD_BORDER_SIDE,
+                               GColorBlack, STANDARD_BORDER_WIDTH, parent_layer);
+    for(i = 0; i < LAYOUT_STANDARD_HEXAGONS; i++){
+        hexagon = hexagon_grid_add(grid, centers[i], color);
+        if( hexagons )
+            hexagons[i] = hexagon;
+    }
+    return grid;
+}
+
+void layout_init_standard_texts(t_hexagon_grid *grid){
+    static const struct {
+        int16_t hexagon;
+        const char *legend;
+    } texts[] = {
+        { HEX_MONTH, "mon" },
+        { HEX_DAY, "day" },
+        { HEX_DAYNUM, "day" },
+        { HEX_WEEK, "week" },
+        { HEX_YEAR, "year" },
+        { HEX_BATT, "batt" }
+    };
+    t_hexagon *hexagon;
+    int16_t i;
+
+    for(i = 0; i < (int16_t)ARRAY_LENGTH(texts); i++){
+        hexagon = &grid->hexagons[texts[i].hexagon];
+        hexagon_init_text(hexagon, GRect(0, 5, 52, 40), GColorBlack, "   ",
+                          fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
+        hexagon_set_legend(hexagon, texts[i].legend);
+    }
+}
+
+/** ----------------------------------------------------------------------------
+ * Rows are a whole number of pixels apart, so that they stack without gaps.
+ */
+t_hexagon_grid *layout_create_dense(t_hexagon **hexagons, int16_t columns, int16_t rows,
+                                    int16_t side, GColor color, Layer *parent_layer){
+    int16_t half_height = side * HALF_SQRT_3;
+    int16_t left = (144 - (columns - 1) * side * 3 / 2) / 2;
+    int16_t top = (168 - (2 * rows - 1) * half_height) / 2;
+    t_hexagon_grid *grid;
+    t_hexagon *hexagon;
+    int16_t row, column;
+
+    grid = create_hexagon_grid(columns * rows, side, side - 2, GColorBlack, 1, parent_layer);
+    for(row = 0; row < rows; row++){
+        for(column = 0; column < columns; column++){
+            hexagon = hexagon_grid_add(grid, GPoint(left + column * side * 3 / 2,
+                                                    top + (2 * row + column % 2) * half_height),
+                                       color);
+            if( hexagons )
+                hexagons[row * columns + column] = hexagon;
+        }
+    }
+    return grid;
+}
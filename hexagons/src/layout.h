@@ -0,0 +1,67 @@
+/*
+ *   Copyright (C) 2015 Maxime Chevallier
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software Foundation,
+ *   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ *   Layouts of the hexagons on the screen header file
+ */
+
+#include <pebble.h>
+#include "hexagon.h"
+
+#ifndef LAYOUT_H
+#define	LAYOUT_H
+
+#define LAYOUT_STANDARD_HEXAGONS 18
+
+/* Hexagons of the standard layout that show text */
+#define HEX_DAYNUM 7
+#define HEX_DAY 6
+#define HEX_WEEK 8
+#define HEX_YEAR 15
+#define HEX_BATT 1
+#define HEX_MONTH 0
+
+/**
+ * @brief Creates the 18 hexagons of the watchface, numbered as in layout.c
+ * @param hexagons filled with the hexagons in layout order, can be NULL
+ * @param color the initial color of all the hexagons
+ * @param parent_layer
+ * @return the grid, owned by the caller
+ */
+t_hexagon_grid *layout_create_standard(t_hexagon **hexagons, GColor color, Layer *parent_layer);
+
+/**
+ * @brief Sets up the labels and the legends of the text hexagons of a grid
+ * created by layout_create_standard()
+ * @param grid
+ */
+void layout_init_standard_texts(t_hexagon_grid *grid);
+
+/**
+ * @brief Tiles the screen with columns x rows small hexagons, numbered row by
+ * row, the odd columns half a row lower. The tiling is centered, the hexagons
+ * on the edges are cut.
+ * @param hexagons filled with the hexagons in layout order, can be NULL
+ * @param columns
+ * @param rows
+ * @param side the width of each side of the hexagons
+ * @param color the initial color of all the hexagons
+ * @param parent_layer
+ * @return the grid, owned by the caller
+ */
+t_hexagon_grid *layout_create_dense(t_hexagon **hexagons, int16_t columns, int16_t rows,
+                                    int16_t side, GColor color, Layer *parent_layer);
+
+#endif	/* LAYOUT_H */
@@ -0,0 +1,219 @@
+/*
+ *   Copyright (C) 2015 Maxime Chevallier
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software Foundation,
+ *   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ *
+ *   Checks the bit sliced automaton against a plain implementation that
+ *   finds the neighbors from the distance between the hexagons, and holds a
+ *   generation to a time budget.
+ */
+
+#include <stdio.h>
+
+#include <pebble.h>
+#include <hexagon.h>
+#include <automaton.h>
+#include <layout.h>
+
+/* Average time of a generation, in nanoseconds */
+#ifndef STEP_BUDGET_NS
+#define STEP_BUDGET_NS 1000
+#endif
+
+#define NB_RANDOM_STATES 20000
+#define NB_TIMED_STEPS 1000000
+
+static int s_failures = 0;
+
+#define CHECK(condition, ...) do{ \
+        if( !(condition) ){ \
+            if( s_failures++ < 20 ){ \
+                printf("FAIL " __VA_ARGS__); \
+                printf("\n"); \
+            } \
+        } \
+    }while(0)
+
+typedef struct{
+    int16_t nb_cells;
+    GPoint origins[AUTOMATON_MAX_CELLS];
+    /* neighbors[i] is the mask of the hexagons touching hexagon i */
+    uint32_t neighbors[AUTOMATON_MAX_CELLS];
+} t_reference;
+
+static int32_t distance2(GPoint a, GPoint b){
+    return (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y);
+}
+
+/**
+ * @brief Two hexagons are neighbors when they are about as close as the two
+ * closest hexagons of the grid
+ */
+static void reference_init(t_reference *reference){
+    int32_t min = INT32_MAX, d;
+    int16_t i, j;
+
+    for(i = 0; i < reference->nb_cells; i++)
+        for(j = 0; j < i; j++)
+            if( distance2(reference->origins[i], reference->origins[j]) < min )
+                min = distance2(reference->origins[i], reference->origins[j]);
+
+    for(i = 0; i < reference->nb_cells; i++){
+        reference->neighbors[i] = 0;
+        for(j = 0; j < reference->nb_cells; j++){
+            d = distance2(reference->origins[i], reference->origins[j]);
+            /* 1.2 times the smallest distance */
+            if( i != j && d * 100 <= min * 144 )
+                reference->neighbors[i] |= (uint32_t)1 << j;
+        }
+    }
+}
+
+static uint32_t reference_step(const t_reference *reference, uint32_t alive, uint32_t pinned){
+    uint32_t next = 0;
+    int16_t i, count;
+
+    for(i = 0; i < reference->nb_cells; i++){
+        count = __builtin_popcount(alive & reference->neighbors[i]);
+        if( alive & ((uint32_t)1 << i) ){
+            if( count == 3 || count == 4 )
+                next |= (uint32_t)1 << i;
+        }else if( count == 2 ){
+            next |= (uint32_t)1 << i;
+        }
+    }
+    return next | pinned;
+}
+
+static uint32_t random_cells(int16_t nb_cells){
+    uint32_t all = nb_cells == 32 ? UINT32_MAX : ((uint32_t)1 << nb_cells) - 1;
+
+    return (((uint32_t)rand() << 16) ^ (uint32_t)rand()) & all;
+}
+
+static void check_random_states(const char *what, const t_reference *reference, uint32_t pinned){
+    uint32_t cells, expected, flipped;
+    int i;
+
+    CHECK(automaton_init(reference->origins, reference->nb_cells), "%s does not fit", what);
+    automaton_set_pinned(pinned);
+
+    for(i = 0; i < NB_RANDOM_STATES; i++){
+        cells = random_cells(reference->nb_cells) | pinned;
+        automaton_set_cells(cells);
+        expected = reference_step(reference, cells, pinned);
+        flipped = automaton_step();
+        CHECK(automaton_get_cells() == expected, "%s : 0x%08X gave 0x%08X instead of 0x%08X",
+              what, cells, automaton_get_cells(), expected);
+        CHECK(flipped == (cells ^ expected), "%s : wrong flipped mask for 0x%08X", what, cells);
+    }
+}
+
+/**
+ * @brief The 18 hexagons of the watchface, the text hexagons pinned
+ */
+static void test_standard_layout(){
+    t_hexagon_grid *grid = layout_create_standard(NULL, GColorBlack, stub_root_layer());
+    t_reference reference;
+    uint32_t pinned = 0;
+    int16_t i;
+
+    layout_init_standard_texts(grid);
+    reference.nb_cells = grid->nb_hexagons;
+    for(i = 0; i < grid->nb_hexagons; i++){
+        reference.origins[i] = grid->hexagons[i].origin;
+        if( grid->hexagons[i].text )
+            pinned |= (uint32_t)1 << i;
+    }
+    destroy_hexagon_grid(grid);
+
+    reference_init(&reference);
+    check_random_states("standard layout", &reference, 0);
+    check_random_states("standard layout pinned", &reference, pinned);
+}
+
+/**
+ * @brief A full 8 columns by 4 rows tiling, where the shifts wrap from a
+ * column to the next one
+ */
+static void test_full_grid(){
+    t_reference reference;
+    int16_t row, column;
+
+    reference.nb_cells = 0;
+    for(column = 0; column < 8; column++){
+        for(row = 0; row < 4; row++)
+            reference.origins[reference.nb_cells++] = GPoint(39 * column, 45 * row + (column % 2) * 22);
+    }
+
+    reference_init(&reference);
+    check_random_states("full grid", &reference, 0);
+}
+
+static void test_too_large(){
+    GPoint origins[3] = { GPoint(0, 0), GPoint(10, 0), GPoint(80, 0) };
+
+    CHECK(!automaton_init(origins, 3), "9 columns fit in the automaton");
+    automaton_set_cells(7);
+    CHECK(automaton_step() == 0 && automaton_get_cells() == 0,
+          "a failed init left cells in the automaton");
+}
+
+static double now_ns(){
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+static void test_step_budget(){
+    t_hexagon_grid *grid = layout_create_standard(NULL, GColorBlack, stub_root_layer());
+    GPoint origins[AUTOMATON_MAX_CELLS];
+    volatile uint32_t sink = 0;
+    double start, step_ns;
+    int16_t i;
+    int n;
+
+    layout_init_standard_texts(grid);
+    for(i = 0; i < grid->nb_hexagons; i++)
+        origins[i] = grid->hexagons[i].origin;
+    automaton_init(origins, grid->nb_hexagons);
+    automaton_set_pinned(0);
+
+    start = now_ns();
+    for(n = 0; n < NB_TIMED_STEPS; n++){
+        /* Reseed now and then, a stable grid would be unrealistically cheap */
+        if( (n & 63) == 0 )
+            automaton_set_cells(random_cells(grid->nb_hexagons));
+        sink ^= automaton_step();
+    }
+    step_ns = (now_ns() - start) / NB_TIMED_STEPS;
+    destroy_hexagon_grid(grid);
+
+    printf("automaton_test : %.1f ns per generation, budget %d ns\n", step_ns, STEP_BUDGET_NS);
+    CHECK(step_ns <= STEP_BUDGET_NS, "a generation takes %.1f ns", step_ns);
+}
+
+int main(void){
+    srand(42);
+
+    test_standard_layout();
+    test_full_grid();
+    test_too_large();
+    test_step_budget();
+
+    printf("automaton_test : %d failures\n", s_failures);
+    return s_failures ? 1 : 0;
+}
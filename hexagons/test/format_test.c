@@ -0,0 +1,109 @@
+/*
+ *   Copyright (C) 2015 Maxime Chevallier
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software Foundation,
+ *   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ *
+ *   Checks the formatters byte for byte against strftime and snprintf, for
+ *   every day from 1995 to 2045.
+ */
+
+#include <stdio.h>
+
+#include <pebble.h>
+#include <format.h>
+
+static int s_failures = 0;
+
+static void check_string(const char *what, const char *expected, const char *actual){
+    if( strcmp(expected, actual) == 0 )
+        return;
+    if( s_failures++ < 20 )
+        printf("FAIL %s : expected \"%s\", got \"%s\"\n", what, expected, actual);
+}
+
+static void check_numbers(){
+    char expected[8], actual[8];
+    int i;
+
+    for(i = 0; i < 100; i++){
+        snprintf(expected, sizeof(expected), "%02d", i);
+        format_two_digits(actual, i);
+        check_string("format_two_digits", expected, actual);
+    }
+    for(i = 0; i < 1000; i++){
+        snprintf(expected, sizeof(expected), "%d", i);
+        format_uint(actual, i);
+        check_string("format_uint", expected, actual);
+    }
+}
+
+static void check_day(const struct tm *day){
+    struct tm hour = *day;
+    char expected[16], actual[16];
+
+    strftime(expected, sizeof(expected), "%V", day);
+    format_two_digits(actual, format_iso_week(day));
+    check_string("format_iso_week", expected, actual);
+
+    strftime(expected, sizeof(expected), "%b", day);
+    check_string("format_month_abbr", expected, format_month_abbr(day));
+
+    strftime(expected, sizeof(expected), "%a", day);
+    check_string("format_day_abbr", expected, format_day_abbr(day));
+
+    for(hour.tm_hour = 0; hour.tm_hour < 24; hour.tm_hour++){
+        strftime(expected, sizeof(expected), "%H", &hour);
+        format_hour(actual, &hour, true);
+        check_string("format_hour 24h", expected, actual);
+
+        strftime(expected, sizeof(expected), "%I", &hour);
+        format_hour(actual, &hour, false);
+        check_string("format_hour 12h", expected, actual);
+    }
+}
+
+static void check_locale(const char *locale, const char *january, const char *sunday){
+    struct tm day = { .tm_mday = 1, .tm_mon = 0, .tm_wday = 0 };
+
+    g_stub_locale = locale;
+    format_init();
+    check_string(locale, january, format_month_abbr(&day));
+    check_string(locale, sunday, format_day_abbr(&day));
+}
+
+int main(void){
+    struct tm start = { .tm_year = 95, .tm_mon = 0, .tm_mday = 1 };
+    time_t t, end;
+    int nb_days = 0;
+
+    check_numbers();
+
+    /* The C locale of strftime has the english names */
+    g_stub_locale = "en_US";
+    format_init();
+
+    t = timegm(&start);
+    start.tm_year = 146;
+    end = timegm(&start);
+    for( ; t < end; t += 24 * 60 * 60, nb_days++)
+        check_day(gmtime(&t));
+
+    check_locale("fr_FR", "jan", "dim");
+    check_locale("de_DE", "Jan", "So");
+    check_locale("zh_CN", "Jan", "Sun");
+
+    printf("format_test : %d days, %d failures\n", nb_days, s_failures);
+    return s_failures ? 1 : 0;
+}
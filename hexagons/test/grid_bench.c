@@ -0,0 +1,156 @@
+/*
+ *   Copyright (C) 2015 Maxime Chevallier
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software Foundation,
+ *   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ *
+ *   Frame time and heap of the hexagon grid during a color sweep. Host
+ *   timings are only meant to compare renderers and grid sizes with each
+ *   other, a watch is a lot slower. With --scale, the dense tilings of 36
+ *   to 306 hexagons are benched after the standard grid.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <pebble.h>
+#include <hexagon.h>
+#include <layout.h>
+
+/* Heap of each grid, in bytes. 0 to only report it. */
+#ifndef HEAP_BUDGET
+#define HEAP_BUDGET 0
+#endif
+
+/* Host frame time of each grid, in microseconds. 0 to only report it. */
+#ifndef FRAME_BUDGET
+#define FRAME_BUDGET 0
+#endif
+
+#define BENCH_FRAMES 2000
+/* The fastest run is kept, the others were slowed down by the host */
+#define BENCH_RUNS 5
+
+#if defined(PBL_BW)
+#define RENDERER "aplite"
+#elif HEXAGON_PALETTE_RENDERING
+#define RENDERER "palette"
+#elif HEXAGON_ANTIALIASING
+#define RENDERER "spans aa"
+#elif HEXAGON_FRAMEBUFFER_RENDERING
+#define RENDERER "spans"
+#else
+/* Timed against the stand in rasterizer of pebble_stub.c */
+#define RENDERER "gpath stub"
+#endif
+
+static const GColor s_sweep_colors[] = {
+    { GColorGreenARGB8 },
+    { GColorOrangeARGB8 },
+    { GColorCyanARGB8 },
+    { GColorShockingPinkARGB8 },
+    { GColorYellowARGB8 },
+    { GColorRedARGB8 }
+};
+
+/* Dense tilings covering the screen, as the DENSE_MODE of hexagons.c */
+static const struct {
+    int16_t columns;
+    int16_t rows;
+    int16_t side;
+} s_dense_layouts[] = {
+    { 6, 6, 19 },
+    { 8, 9, 13 },
+    { 12, 13, 9 },
+    { 17, 18, 6 }
+};
+
+static double now_us(){
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+/**
+ * @brief Runs sweeps over the whole grid, one hexagon changing color and the
+ * layer being redrawn at each frame.
+ * @return the average frame time of the fastest run, in microseconds
+ */
+static double bench_sweep(t_hexagon_grid *grid, GContext *context){
+    double start, frame_us, best_us = 0;
+    int frame, run;
+
+    for(run = 0; run < BENCH_RUNS; run++){
+        start = now_us();
+        for(frame = 0; frame < BENCH_FRAMES; frame++){
+            hexagon_set_color(&grid->hexagons[frame % grid->nb_hexagons],
+                              s_sweep_colors[(frame / grid->nb_hexagons) % ARRAY_LENGTH(s_sweep_colors)]);
+            stub_layer_render(grid->layer, context);
+        }
+        frame_us = (now_us() - start) / BENCH_FRAMES;
+        if( run == 0 || frame_us < best_us )
+            best_us = frame_us;
+    }
+    return best_us;
+}
+
+/**
+ * @brief Benches a grid, prints its line and destroys it. The heap is the
+ * peak during the sweep, which includes what is built at the first draw.
+ * @param heap_start heap used before the grid was created, the peak being
+ * reset then
+ * @return true when the grid is within the budgets
+ */
+static bool bench_grid(t_hexagon_grid *grid, size_t heap_start, GContext *context){
+    double frame_us = bench_sweep(grid, context);
+    size_t heap = heap_peak_bytes() - heap_start;
+    bool over_budget = (HEAP_BUDGET && heap > HEAP_BUDGET) ||
+                       (FRAME_BUDGET && frame_us > FRAME_BUDGET);
+
+    printf("%-10s %5d %8d B %9.2f us%s%s\n", RENDERER,
+           grid->nb_hexagons, (int)heap, frame_us,
+           hexagon_grid_get_nb_bands(grid) < 0 ? "  span fallback" : "",
+           over_budget ? "  OVER BUDGET" : "");
+    destroy_hexagon_grid(grid);
+    return !over_budget;
+}
+
+int main(int argc, char **argv){
+    GContext *context = stub_context_create();
+    bool scale = argc > 1 && !strcmp(argv[1], "--scale");
+    bool within_budget;
+    t_hexagon_grid *grid;
+    size_t heap_start;
+    int i;
+
+    printf("%-10s %5s %10s %12s\n", "renderer", "cells", "heap", "frame");
+
+    heap_reset_peak();
+    heap_start = heap_bytes_used();
+    grid = layout_create_standard(NULL, GColorBlack, stub_root_layer());
+    layout_init_standard_texts(grid);
+    within_budget = bench_grid(grid, heap_start, context);
+
+    for(i = 0; scale && i < (int)ARRAY_LENGTH(s_dense_layouts); i++){
+        heap_reset_peak();
+        heap_start = heap_bytes_used();
+        grid = layout_create_dense(NULL, s_dense_layouts[i].columns, s_dense_layouts[i].rows,
+                                   s_dense_layouts[i].side, GColorBlack, stub_root_layer());
+        within_budget &= bench_grid(grid, heap_start, context);
+    }
+
+    stub_context_destroy(context);
+    return within_budget ? 0 : 1;
+}
@@ -0,0 +1,280 @@
+/*
+ *   Copyright (C) 2015 Maxime Chevallier
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software Foundation,
+ *   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ *
+ *   Checks the rendering of the hexagon grid
+ */
+
+#include <stdio.h>
+
+#include <pebble.h>
+#include <hexagon.h>
+#include <layout.h>
+
+static int s_failures = 0;
+
+#define CHECK(condition, ...) do{ \
+        if( !(condition) ){ \
+            s_failures++; \
+            printf("FAIL " __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    }while(0)
+
+#if defined(PBL_BW)
+/* Same colors and order as next_color() in hexagons.c */
+static const GColor s_sweep_colors[] = {
+    { GColorGreenARGB8 },
+    { GColorOrangeARGB8 },
+    { GColorCyanARGB8 },
+    { GColorShockingPinkARGB8 },
+    { GColorYellowARGB8 },
+    { GColorRedARGB8 }
+};
+
+#define NB_SWEEP_COLORS ((int)ARRAY_LENGTH(s_sweep_colors))
+
+/* Pixels that must differ, out of the 16 of a dithering pattern */
+#define MIN_PATTERN_CONTRAST 4
+
+static int count_bits(uint8_t value){
+    int n = 0;
+
+    for( ; value; value >>= 1)
+        n += value & 1;
+    return n;
+}
+
+/**
+ * @brief Renders a single hexagon in each sweep color, and checks that two
+ * following colors are told apart by their dithering pattern
+ */
+static void test_sweep_contrast(){
+    GContext *context = stub_context_create();
+    GBitmap *framebuffer = graphics_capture_frame_buffer(context);
+    t_hexagon_grid *grid = create_hexagon_grid(1, 26, 22, GColorBlack, 3, stub_root_layer());
+    t_hexagon *hexagon = hexagon_grid_add(grid, GPoint(72, 84), GColorBlack);
+    uint8_t patterns[NB_SWEEP_COLORS][4];
+    uint16_t bytes_per_row = gbitmap_get_bytes_per_row(framebuffer);
+    int i, next, row, diff;
+
+    /* A byte well inside the hexagon, for 4 rows */
+    for(i = 0; i < NB_SWEEP_COLORS; i++){
+        hexagon_set_color(hexagon, s_sweep_colors[i]);
+        stub_layer_render(grid->layer, context);
+        for(row = 0; row < 4; row++)
+            patterns[i][row] = gbitmap_get_data(framebuffer)[(84 + row) * bytes_per_row + 72 / 8];
+    }
+
+    for(i = 0; i < NB_SWEEP_COLORS; i++){
+        next = (i + 1) % NB_SWEEP_COLORS;
+        /* A byte holds the 4 pixel pattern twice */
+        diff = 0;
+        for(row = 0; row < 4; row++)
+            diff += count_bits((patterns[i][row] ^ patterns[next][row]) & 0x0F);
+        CHECK(diff >= MIN_PATTERN_CONTRAST,
+              "sweep colors %d and %d differ by %d pixels", i, next, diff);
+    }
+
+    destroy_hexagon_grid(grid);
+    stub_context_destroy(context);
+}
+#endif
+
+#if HEXAGON_PALETTE_RENDERING
+/**
+ * @brief Checks that the center pixel of every hexagon on screen has the
+ * hexagon color
+ */
+static void check_centers(const char *what, t_hexagon_grid *grid, GContext *context){
+    GBitmap *framebuffer = graphics_capture_frame_buffer(context);
+    GSize size = gbitmap_get_bounds(framebuffer).size;
+    t_hexagon *hexagon;
+    int16_t i, x, y;
+    uint8_t pixel;
+
+    for(i = 0; i < grid->nb_hexagons; i++){
+        hexagon = &grid->hexagons[i];
+        x = hexagon->origin.x + grid->side_width;
+        y = hexagon->origin.y + grid->height / 2;
+        if( x < 0 || x >= size.w || y < 0 || y >= size.h )
+            continue;
+        pixel = gbitmap_get_data(framebuffer)[y * gbitmap_get_bytes_per_row(framebuffer) + x];
+        CHECK(pixel == hexagon->color.argb, "%s : hexagon %d is 0x%02X instead of 0x%02X",
+              what, i, pixel, hexagon->color.argb);
+    }
+}
+
+/**
+ * @brief Builds the bands of the watchface grid, and checks that a recolor
+ * only changes the palettes
+ */
+static void test_standard_bands(){
+    GContext *context = stub_context_create();
+    t_hexagon_grid *grid = layout_create_standard(NULL, GColorBlack, stub_root_layer());
+    GBitmap *bitmap;
+    uint8_t *before[4];
+    size_t band_size;
+    int16_t nb_bands, i;
+
+    layout_init_standard_texts(grid);
+    for(i = 0; i < grid->nb_hexagons; i++)
+        hexagon_set_color(&grid->hexagons[i], (GColor){ .argb = 0xC1 + i });
+    stub_layer_render(grid->layer, context);
+
+    nb_bands = hexagon_grid_get_nb_bands(grid);
+    CHECK(nb_bands >= 0, "standard grid overflows the bands");
+    CHECK(nb_bands == 2, "standard grid in %d bands instead of 2", nb_bands);
+    check_centers("standard", grid, context);
+
+    for(i = 0; i < nb_bands && i < 4; i++){
+        bitmap = hexagon_grid_get_band_bitmap(grid, i);
+        band_size = gbitmap_get_bytes_per_row(bitmap) * gbitmap_get_bounds(bitmap).size.h;
+        before[i] = malloc(band_size);
+        memcpy(before[i], gbitmap_get_data(bitmap), band_size);
+    }
+
+    hexagon_set_color(&grid->hexagons[2], GColorRed);
+    stub_layer_render(grid->layer, context);
+    check_centers("recolored", grid, context);
+
+    for(i = 0; i < nb_bands && i < 4; i++){
+        bitmap = hexagon_grid_get_band_bitmap(grid, i);
+        band_size = gbitmap_get_bytes_per_row(bitmap) * gbitmap_get_bounds(bitmap).size.h;
+        CHECK(memcmp(before[i], gbitmap_get_data(bitmap), band_size) == 0,
+              "recolor rasterized band %d again", i);
+        free(before[i]);
+    }
+
+    destroy_hexagon_grid(grid);
+    stub_context_destroy(context);
+}
+
+/**
+ * @brief A row of 16 hexagons does not fit in a palette : the grid must be
+ * drawn anyway, without the bands
+ */
+static void test_band_overflow(){
+    GContext *context = stub_context_create();
+    t_hexagon_grid *grid = create_hexagon_grid(16, 4, 3, GColorBlack, 1, stub_root_layer());
+    int16_t i;
+
+    for(i = 0; i < 16; i++)
+        hexagon_grid_add(grid, GPoint(6 + 9 * i, 84), (GColor){ .argb = 0xC1 + i });
+    stub_layer_render(grid->layer, context);
+
+    CHECK(hexagon_grid_get_nb_bands(grid) < 0, "16 hexagons on a row fit in the bands");
+    check_centers("overflow", grid, context);
+
+    destroy_hexagon_grid(grid);
+    stub_context_destroy(context);
+}
+#endif
+
+#if defined(PBL_COLOR)
+/* Basalt timeline peek */
+#define PEEK_HEIGHT 51
+
+/**
+ * @brief Counts the pixels of a color in the visible rows of the screen
+ */
+static int count_pixels(GContext *context, int16_t visible_height, GColor color){
+    GBitmap *framebuffer = graphics_capture_frame_buffer(context);
+    uint8_t *data = gbitmap_get_data(framebuffer);
+    int16_t width = gbitmap_get_bounds(framebuffer).size.w;
+    int count = 0;
+    int16_t x, y;
+
+    for(y = 0; y < visible_height; y++)
+        for(x = 0; x < width; x++)
+            count += data[y * gbitmap_get_bytes_per_row(framebuffer) + x] == color.argb;
+    return count;
+}
+
+/**
+ * @brief With a timeline peek, each text hexagon of the watchface must keep
+ * at least half of its pixels above the peek
+ */
+static void test_peek(){
+    static const int16_t text_hexagons[] = {
+        HEX_MONTH, HEX_BATT, HEX_DAY, HEX_DAYNUM, HEX_WEEK, HEX_YEAR
+    };
+    GContext *context = stub_context_create();
+    t_hexagon_grid *grid = layout_create_standard(NULL, GColorWhite, stub_root_layer());
+    GBitmap *framebuffer = graphics_capture_frame_buffer(context);
+    size_t framebuffer_size = gbitmap_get_bytes_per_row(framebuffer) *
+                              gbitmap_get_bounds(framebuffer).size.h;
+    int16_t visible_height = gbitmap_get_bounds(framebuffer).size.h - PEEK_HEIGHT;
+    int full[ARRAY_LENGTH(text_hexagons)];
+    int peek;
+    GColor color;
+    size_t i;
+
+    layout_init_standard_texts(grid);
+    for(i = 0; i < ARRAY_LENGTH(text_hexagons); i++)
+        hexagon_set_color(&grid->hexagons[text_hexagons[i]], (GColor){ .argb = 0xC1 + i });
+
+    stub_layer_render(grid->layer, context);
+    for(i = 0; i < ARRAY_LENGTH(text_hexagons); i++)
+        full[i] = count_pixels(context, gbitmap_get_bounds(framebuffer).size.h,
+                               (GColor){ .argb = 0xC1 + i });
+
+    memset(gbitmap_get_data(framebuffer), 0, framebuffer_size);
+    hexagon_grid_set_visible_height(grid, visible_height);
+    stub_layer_render(grid->layer, context);
+
+    for(i = 0; i < ARRAY_LENGTH(text_hexagons); i++){
+        color = (GColor){ .argb = 0xC1 + i };
+        peek = count_pixels(context, visible_height, color);
+        CHECK(peek * 2 >= full[i], "peek : hexagon %d keeps %d of %d pixels",
+              text_hexagons[i], peek, full[i]);
+    }
+
+    destroy_hexagon_grid(grid);
+    stub_context_destroy(context);
+}
+#endif
+
+/**
+ * @brief Checks that the grid frees all its memory
+ */
+static void test_no_leak(){
+    size_t before = heap_bytes_used();
+    t_hexagon_grid *grid = layout_create_standard(NULL, GColorBlack, stub_root_layer());
+
+    layout_init_standard_texts(grid);
+    destroy_hexagon_grid(grid);
+    CHECK(heap_bytes_used() == before, "%d bytes leaked",
+          (int)(heap_bytes_used() - before));
+}
+
+int main(void){
+#if defined(PBL_BW)
+    test_sweep_contrast();
+#endif
+#if HEXAGON_PALETTE_RENDERING
+    test_standard_bands();
+    test_band_overflow();
+#endif
+#if defined(PBL_COLOR)
+    test_peek();
+#endif
+    test_no_leak();
+
+    printf("grid_test%s%s : %d failures\n", PBL_IF_COLOR_ELSE("", "_bw"),
+           HEXAGON_PALETTE_RENDERING ? "_palette" : "", s_failures);
+    return s_failures ? 1 : 0;
+}
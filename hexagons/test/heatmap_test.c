@@ -0,0 +1,173 @@
+/*
+ *   Copyright (C) 2015 Maxime Chevallier
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software Foundation,
+ *   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ *
+ *   Checks the catch up of the heatmap buckets against a fake health service
+ *   and persistent storage : gaps, the 12 hours clamp, the changed slots and
+ *   the hours whose steps are not available.
+ */
+
+#include <stdio.h>
+
+#include <pebble.h>
+#include <heatmap.h>
+
+/* An even hour, the fake health service walks during the odd hours */
+#define T0 ((time_t)(200000 * 2) * SECONDS_PER_HOUR)
+#define ACTIVE_STEPS 6000
+
+static int s_failures = 0;
+
+#define CHECK(condition, ...) do{ \
+        if( !(condition) ){ \
+            s_failures++; \
+            printf("FAIL " __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    }while(0)
+
+static bool s_accessible;
+static int s_queries;
+
+static uint8_t s_storage[256];
+static size_t s_storage_size;
+
+HealthServiceAccessibilityMask health_service_metric_accessible(HealthMetric metric,
+                                                                time_t time_start,
+                                                                time_t time_end){
+    return s_accessible ? HealthServiceAccessibilityMaskAvailable :
+                          HealthServiceAccessibilityMaskNoPermission;
+}
+
+HealthValue health_service_sum(HealthMetric metric, time_t time_start, time_t time_end){
+    s_queries++;
+    return (time_start / SECONDS_PER_HOUR) % 2 ? ACTIVE_STEPS : 0;
+}
+
+bool persist_exists(const uint32_t key){
+    return s_storage_size > 0;
+}
+
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size){
+    size_t size = buffer_size < s_storage_size ? buffer_size : s_storage_size;
+
+    memcpy(buffer, s_storage, size);
+    return size;
+}
+
+int persist_write_data(const uint32_t key, const void *data, const size_t size){
+    s_storage_size = size < sizeof(s_storage) ? size : sizeof(s_storage);
+    memcpy(s_storage, data, s_storage_size);
+    return s_storage_size;
+}
+
+static int slot(time_t t){
+    return (t / SECONDS_PER_HOUR) % HEATMAP_HOURS;
+}
+
+/**
+ * @brief Starts the heatmap at now, with empty storage
+ */
+static void heatmap_restart(time_t now, bool accessible){
+    s_storage_size = 0;
+    s_accessible = accessible;
+    heatmap_init(now);
+    s_queries = 0;
+}
+
+/**
+ * @brief Checks the color of the hours that ended against the fake health
+ * service. The hour in progress is empty.
+ */
+static void check_hours(const char *test, time_t now){
+    time_t current = now - now % SECONDS_PER_HOUR;
+    GColor empty = heatmap_get_color(slot(current));
+    GColor expected;
+    time_t start;
+
+    for(start = current - (HEATMAP_HOURS - 1) * SECONDS_PER_HOUR; start < current; start += SECONDS_PER_HOUR){
+        expected = (start / SECONDS_PER_HOUR) % 2 ? GColorRed : empty;
+        CHECK(gcolor_equal(heatmap_get_color(slot(start)), expected),
+              "%s : hour %d is 0x%02X instead of 0x%02X", test,
+              (int)((start - current) / SECONDS_PER_HOUR),
+              heatmap_get_color(slot(start)).argb, expected.argb);
+    }
+}
+
+static void test_catch_up(){
+    heatmap_restart(T0, true);
+
+    CHECK(heatmap_update(T0 + 59 * 60) == 0, "catch up : an update within the hour changed slots");
+    CHECK(s_queries == 0, "catch up : %d queries within the hour", s_queries);
+
+    heatmap_update(T0 + 3 * SECONDS_PER_HOUR + 10 * 60);
+    CHECK(s_queries == 3, "catch up : %d queries for a 3 hours gap", s_queries);
+    check_hours("catch up", T0 + 3 * SECONDS_PER_HOUR);
+}
+
+static void test_clamp(){
+    heatmap_restart(T0, true);
+
+    heatmap_update(T0 + 100 * SECONDS_PER_HOUR);
+    CHECK(s_queries == HEATMAP_HOURS - 1, "clamp : %d queries for a 100 hours gap", s_queries);
+    check_hours("clamp", T0 + 100 * SECONDS_PER_HOUR);
+}
+
+static void test_changed_mask(){
+    uint16_t changed;
+
+    heatmap_restart(T0, true);
+    CHECK(heatmap_init(T0) == (1 << HEATMAP_HOURS) - 1, "mask : init does not set all the slots");
+
+    /* T0 stays empty, the slot of T0 + 1 h drops the steps of T0 - 11 h */
+    changed = heatmap_update(T0 + SECONDS_PER_HOUR);
+    CHECK(changed == 1 << slot(T0 + SECONDS_PER_HOUR), "mask : 0x%03X after the first hour", changed);
+
+    /* T0 + 1 h gets steps, the slot of T0 + 2 h was already empty */
+    changed = heatmap_update(T0 + 2 * SECONDS_PER_HOUR);
+    CHECK(changed == 1 << slot(T0 + SECONDS_PER_HOUR), "mask : 0x%03X after the second hour", changed);
+}
+
+static void test_unavailable(){
+    int i;
+
+    heatmap_restart(T0, false);
+    for(i = 0; i < HEATMAP_HOURS; i++)
+        CHECK(gcolor_equal(heatmap_get_color(i), heatmap_get_color(slot(T0))),
+              "unavailable : slot %d is not empty", i);
+
+    /* Granting the permission within the same hour brings the steps back */
+    s_accessible = true;
+    heatmap_update(T0 + 30 * 60);
+    CHECK(s_queries == HEATMAP_HOURS - 1, "unavailable : %d queries once available", s_queries);
+    check_hours("unavailable", T0);
+
+    /* And they were saved */
+    s_queries = 0;
+    heatmap_init(T0 + 40 * 60);
+    CHECK(s_queries == 0, "unavailable : %d queries after a restart", s_queries);
+    check_hours("unavailable restart", T0);
+}
+
+int main(void){
+    test_catch_up();
+    test_clamp();
+    test_changed_mask();
+    test_unavailable();
+
+    printf("heatmap_test : %d failures\n", s_failures);
+    return s_failures ? 1 : 0;
+}
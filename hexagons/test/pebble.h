@@ -0,0 +1,249 @@
+/*
+ *   Copyright (C) 2015 Maxime Chevallier
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software Foundation,
+ *   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ *
+ *   Stub of the Pebble SDK header, with just enough of the API to build the
+ *   watchface modules on the host for the tests and benchmarks.
+ */
+
+#ifndef PEBBLE_STUB_H
+#define	PEBBLE_STUB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Build with -DPBL_BW for aplite, color platforms otherwise */
+#ifndef PBL_BW
+#define PBL_COLOR 1
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_true)
+#else
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_false)
+#endif
+
+#define ARRAY_LENGTH(array) (sizeof(array) / sizeof((array)[0]))
+
+/* The heap is accounted, see heap_bytes_used() */
+#define malloc(size) stub_malloc(size)
+#define free(pointer) stub_free(pointer)
+void *stub_malloc(size_t size);
+void stub_free(void *pointer);
+size_t heap_bytes_used(void);
+/* Highest heap_bytes_used() since the last heap_reset_peak() */
+size_t heap_peak_bytes(void);
+void heap_reset_peak(void);
+
+#define APP_LOG_LEVEL_ERROR 1
+#define APP_LOG_LEVEL_DEBUG 200
+#define APP_LOG(level, ...) stub_log(level, __VA_ARGS__)
+void stub_log(uint8_t level, const char *format, ...);
+
+/* Locale returned by i18n_get_system_locale(), "en_US" by default */
+extern const char *g_stub_locale;
+
+const char *i18n_get_system_locale(void);
+
+/* ------------------------------- Geometry ----------------------------------*/
+
+typedef struct{
+    int16_t x;
+    int16_t y;
+} GPoint;
+
+typedef struct{
+    int16_t w;
+    int16_t h;
+} GSize;
+
+typedef struct{
+    GPoint origin;
+    GSize size;
+} GRect;
+
+#define GPoint(x, y) ((GPoint){ (x), (y) })
+#define GSize(w, h) ((GSize){ (w), (h) })
+#define GRect(x, y, w, h) ((GRect){ { (x), (y) }, { (w), (h) } })
+
+/* -------------------------------- Colors -----------------------------------*/
+
+typedef union{
+    uint8_t argb;
+    struct{
+        uint8_t b:2;
+        uint8_t g:2;
+        uint8_t r:2;
+        uint8_t a:2;
+    };
+} GColor8;
+
+typedef GColor8 GColor;
+
+#define GColorFromRGBA(red, green, blue, alpha) ((GColor8){ .argb = (uint8_t) \
+    ((((alpha) >> 6) << 6) | (((red) >> 6) << 4) | (((green) >> 6) << 2) | ((blue) >> 6)) })
+
+#define GColorClearARGB8 0x00
+#define GColorBlackARGB8 0xC0
+#define GColorOxfordBlueARGB8 0xC1
+#define GColorDukeBlueARGB8 0xC2
+#define GColorBlueARGB8 0xC3
+#define GColorIslamicGreenARGB8 0xC8
+#define GColorGreenARGB8 0xCC
+#define GColorCyanARGB8 0xCF
+#define GColorDarkGrayARGB8 0xD5
+#define GColorLightGrayARGB8 0xEA
+#define GColorRedARGB8 0xF0
+#define GColorOrangeARGB8 0xF4
+#define GColorShockingPinkARGB8 0xF7
+#define GColorChromeYellowARGB8 0xF8
+#define GColorYellowARGB8 0xFC
+#define GColorWhiteARGB8 0xFF
+
+#define GColorClear ((GColor8){ .argb = GColorClearARGB8 })
+#define GColorBlack ((GColor8){ .argb = GColorBlackARGB8 })
+#define GColorOxfordBlue ((GColor8){ .argb = GColorOxfordBlueARGB8 })
+#define GColorDukeBlue ((GColor8){ .argb = GColorDukeBlueARGB8 })
+#define GColorBlue ((GColor8){ .argb = GColorBlueARGB8 })
+#define GColorIslamicGreen ((GColor8){ .argb = GColorIslamicGreenARGB8 })
+#define GColorGreen ((GColor8){ .argb = GColorGreenARGB8 })
+#define GColorCyan ((GColor8){ .argb = GColorCyanARGB8 })
+#define GColorDarkGray ((GColor8){ .argb = GColorDarkGrayARGB8 })
+#define GColorLightGray ((GColor8){ .argb = GColorLightGrayARGB8 })
+#define GColorRed ((GColor8){ .argb = GColorRedARGB8 })
+#define GColorOrange ((GColor8){ .argb = GColorOrangeARGB8 })
+#define GColorShockingPink ((GColor8){ .argb = GColorShockingPinkARGB8 })
+#define GColorChromeYellow ((GColor8){ .argb = GColorChromeYellowARGB8 })
+#define GColorYellow ((GColor8){ .argb = GColorYellowARGB8 })
+#define GColorWhite ((GColor8){ .argb = GColorWhiteARGB8 })
+
+bool gcolor_equal(GColor8 x, GColor8 y);
+
+/* ------------------------------- Graphics ----------------------------------*/
+
+typedef enum{
+    GBitmapFormat1Bit,
+    GBitmapFormat8Bit,
+    GBitmapFormat4BitPalette
+} GBitmapFormat;
+
+typedef enum{
+    GCompOpAssign,
+    GCompOpSet
+} GCompOp;
+
+typedef enum{
+    GTextOverflowModeWordWrap
+} GTextOverflowMode;
+
+typedef enum{
+    GTextAlignmentCenter
+} GTextAlignment;
+
+typedef struct{
+    uint32_t num_points;
+    GPoint *points;
+} GPathInfo;
+
+typedef struct GBitmap GBitmap;
+typedef struct GContext GContext;
+typedef struct GPath GPath;
+typedef struct Layer Layer;
+typedef struct GTextAttributes GTextAttributes;
+typedef const char *GFont;
+
+typedef void (*LayerUpdateProc)(Layer *layer, GContext *context);
+
+#define FONT_KEY_GOTHIC_14 "GOTHIC_14"
+#define FONT_KEY_GOTHIC_24_BOLD "GOTHIC_24_BOLD"
+
+Layer *layer_create_with_data(GRect frame, size_t data_size);
+void layer_destroy(Layer *layer);
+void *layer_get_data(const Layer *layer);
+GRect layer_get_bounds(const Layer *layer);
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc);
+void layer_add_child(Layer *parent, Layer *child);
+void layer_mark_dirty(Layer *layer);
+
+GBitmap *gbitmap_create_blank_with_palette(GSize size, GBitmapFormat format,
+                                           GColor *palette, bool free_on_destroy);
+void gbitmap_destroy(GBitmap *bitmap);
+uint8_t *gbitmap_get_data(const GBitmap *bitmap);
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap);
+GRect gbitmap_get_bounds(const GBitmap *bitmap);
+
+GPath *gpath_create(const GPathInfo *info);
+void gpath_destroy(GPath *path);
+void gpath_move_to(GPath *path, GPoint point);
+void gpath_draw_filled(GContext *context, GPath *path);
+void gpath_draw_outline(GContext *context, GPath *path);
+
+GBitmap *graphics_capture_frame_buffer(GContext *context);
+bool graphics_release_frame_buffer(GContext *context, GBitmap *bitmap);
+void graphics_context_set_fill_color(GContext *context, GColor color);
+void graphics_context_set_stroke_color(GContext *context, GColor color);
+void graphics_context_set_stroke_width(GContext *context, uint8_t stroke_width);
+void graphics_context_set_text_color(GContext *context, GColor color);
+void graphics_context_set_compositing_mode(GContext *context, GCompOp mode);
+void graphics_draw_bitmap_in_rect(GContext *context, const GBitmap *bitmap, GRect rect);
+void graphics_draw_text(GContext *context, const char *text, GFont font, GRect box,
+                        GTextOverflowMode overflow_mode, GTextAlignment alignment,
+                        GTextAttributes *text_attributes);
+GSize graphics_text_layout_get_content_size(const char *text, GFont font, GRect box,
+                                            GTextOverflowMode overflow_mode,
+                                            GTextAlignment alignment);
+
+GFont fonts_get_system_font(const char *font_key);
+
+/* --------------------------- Health and storage ----------------------------*/
+
+/* Not implemented by pebble_stub.c, the tests that need them provide them */
+
+#define SECONDS_PER_HOUR 3600
+
+typedef int32_t HealthValue;
+
+typedef enum{
+    HealthMetricStepCount
+} HealthMetric;
+
+typedef enum{
+    HealthServiceAccessibilityMaskAvailable = 1 << 0,
+    HealthServiceAccessibilityMaskNoPermission = 1 << 1,
+    HealthServiceAccessibilityMaskNotSupported = 1 << 2,
+    HealthServiceAccessibilityMaskNotAvailable = 1 << 3
+} HealthServiceAccessibilityMask;
+
+HealthServiceAccessibilityMask health_service_metric_accessible(HealthMetric metric,
+                                                                time_t time_start,
+                                                                time_t time_end);
+HealthValue health_service_sum(HealthMetric metric, time_t time_start, time_t time_end);
+
+bool persist_exists(const uint32_t key);
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size);
+int persist_write_data(const uint32_t key, const void *data, const size_t size);
+
+/* ----------------------------- Host helpers --------------------------------*/
+
+/* A 144x168 screen, 1 bit with PBL_BW, 8 bit otherwise */
+GContext *stub_context_create(void);
+void stub_context_destroy(GContext *context);
+Layer *stub_root_layer(void);
+
+/* Runs the update proc of the layer, as a redraw of the screen would */
+void stub_layer_render(Layer *layer, GContext *context);
+
+#endif	/* PEBBLE_STUB_H */
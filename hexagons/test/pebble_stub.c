@@ -0,0 +1,394 @@
+/*
+ *   Copyright (C) 2015 Maxime Chevallier
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software Foundation,
+ *   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+ *
+ *   Host implementation of the stubbed Pebble SDK functions
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include <pebble.h>
+
+#undef malloc
+#undef free
+
+#define SCREEN_WIDTH 144
+#define SCREEN_HEIGHT 168
+
+struct GBitmap{
+    uint8_t *data;
+    uint16_t bytes_per_row;
+    GRect bounds;
+    GColor *palette;
+    bool free_palette;
+};
+
+struct GContext{
+    GBitmap framebuffer;
+    GCompOp compositing_mode;
+    GColor fill_color;
+    GColor stroke_color;
+    uint8_t stroke_width;
+};
+
+struct GPath{
+    GPathInfo info;
+    GPoint offset;
+};
+
+struct Layer{
+    GRect bounds;
+    LayerUpdateProc update_proc;
+    void *data;
+};
+
+/* Each block starts with its size, to account for it when it is freed */
+typedef union{
+    size_t size;
+    uint64_t align;
+} t_block_header;
+
+static size_t s_heap_used = 0;
+static size_t s_heap_peak = 0;
+
+void *stub_malloc(size_t size){
+    t_block_header *header = malloc(sizeof(t_block_header) + size);
+
+    if( !header )
+        return NULL;
+    header->size = size;
+    s_heap_used += size;
+    if( s_heap_used > s_heap_peak )
+        s_heap_peak = s_heap_used;
+    return header + 1;
+}
+
+void stub_free(void *pointer){
+    t_block_header *header;
+
+    if( !pointer )
+        return;
+    header = (t_block_header *)pointer - 1;
+    s_heap_used -= header->size;
+    free(header);
+}
+
+size_t heap_bytes_used(void){
+    return s_heap_used;
+}
+
+size_t heap_peak_bytes(void){
+    return s_heap_peak;
+}
+
+void heap_reset_peak(void){
+    s_heap_peak = s_heap_used;
+}
+
+void stub_log(uint8_t level, const char *format, ...){
+    va_list arguments;
+
+    if( level > APP_LOG_LEVEL_ERROR )
+        return;
+    va_start(arguments, format);
+    fprintf(stderr, "[log] ");
+    vfprintf(stderr, format, arguments);
+    fprintf(stderr, "\n");
+    va_end(arguments);
+}
+
+const char *g_stub_locale = "en_US";
+
+const char *i18n_get_system_locale(void){
+    return g_stub_locale;
+}
+
+bool gcolor_equal(GColor8 x, GColor8 y){
+    return x.argb == y.argb;
+}
+
+/* -------------------------------- Layers -----------------------------------*/
+
+Layer *layer_create_with_data(GRect frame, size_t data_size){
+    Layer *layer = stub_malloc(sizeof(Layer) + data_size);
+
+    memset(layer, 0, sizeof(Layer) + data_size);
+    layer->bounds = GRect(0, 0, frame.size.w, frame.size.h);
+    layer->data = layer + 1;
+    return layer;
+}
+
+void layer_destroy(Layer *layer){
+    stub_free(layer);
+}
+
+void *layer_get_data(const Layer *layer){
+    return layer->data;
+}
+
+GRect layer_get_bounds(const Layer *layer){
+    return layer->bounds;
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc){
+    layer->update_proc = update_proc;
+}
+
+void layer_add_child(Layer *parent, Layer *child){
+}
+
+void layer_mark_dirty(Layer *layer){
+}
+
+Layer *stub_root_layer(void){
+    static Layer root = { { { 0, 0 }, { SCREEN_WIDTH, SCREEN_HEIGHT } }, NULL, NULL };
+    return &root;
+}
+
+void stub_layer_render(Layer *layer, GContext *context){
+    if( layer->update_proc )
+        layer->update_proc(layer, context);
+}
+
+/* ------------------------------- Bitmaps -----------------------------------*/
+
+GBitmap *gbitmap_create_blank_with_palette(GSize size, GBitmapFormat format,
+                                           GColor *palette, bool free_on_destroy){
+    GBitmap *bitmap = stub_malloc(sizeof(GBitmap));
+    uint16_t bits = format == GBitmapFormat4BitPalette ? 4 :
+                    format == GBitmapFormat1Bit ? 1 : 8;
+
+    bitmap->bytes_per_row = (size.w * bits + 7) / 8;
+    bitmap->bounds = GRect(0, 0, size.w, size.h);
+    bitmap->data = stub_malloc(bitmap->bytes_per_row * size.h);
+    memset(bitmap->data, 0, bitmap->bytes_per_row * size.h);
+    bitmap->palette = palette;
+    bitmap->free_palette = free_on_destroy;
+    return bitmap;
+}
+
+void gbitmap_destroy(GBitmap *bitmap){
+    if( bitmap->free_palette )
+        stub_free(bitmap->palette);
+    stub_free(bitmap->data);
+    stub_free(bitmap);
+}
+
+uint8_t *gbitmap_get_data(const GBitmap *bitmap){
+    return bitmap->data;
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap){
+    return bitmap->bytes_per_row;
+}
+
+GRect gbitmap_get_bounds(const GBitmap *bitmap){
+    return bitmap->bounds;
+}
+
+/* -------------------------------- Paths ------------------------------------*/
+
+GPath *gpath_create(const GPathInfo *info){
+    GPath *path = stub_malloc(sizeof(GPath));
+
+    path->info = *info;
+    path->offset = GPoint(0, 0);
+    return path;
+}
+
+void gpath_destroy(GPath *path){
+    stub_free(path);
+}
+
+void gpath_move_to(GPath *path, GPoint point){
+    path->offset = point;
+}
+
+/* A stand in for the firmware rasterizer, so that the GPath renderer can be
+ * timed against the span renderers : a pixel is filled when its center is
+ * inside the polygon, and outlines are stamped squares along each edge. */
+static void stub_set_pixel(GContext *context, int16_t x, int16_t y, GColor color){
+    GBitmap *framebuffer = &context->framebuffer;
+
+    if( x < 0 || y < 0 || x >= framebuffer->bounds.size.w || y >= framebuffer->bounds.size.h )
+        return;
+    framebuffer->data[y * framebuffer->bytes_per_row + x] = color.argb;
+}
+
+void gpath_draw_filled(GContext *context, GPath *path){
+    GPoint points[16];
+    float crossings[16], edge_y, swap;
+    int16_t n = path->info.num_points;
+    int16_t min_y = INT16_MAX, max_y = INT16_MIN;
+    int16_t i, j, nb_crossings, x, y;
+    GPoint a, b;
+
+    for(i = 0; i < n; i++){
+        points[i] = GPoint(path->info.points[i].x + path->offset.x,
+                           path->info.points[i].y + path->offset.y);
+        if( points[i].y < min_y )
+            min_y = points[i].y;
+        if( points[i].y > max_y )
+            max_y = points[i].y;
+    }
+
+    for(y = min_y; y <= max_y; y++){
+        edge_y = y + 0.5f;
+        nb_crossings = 0;
+        for(i = 0; i < n; i++){
+            a = points[i];
+            b = points[(i + 1) % n];
+            if( (a.y <= edge_y) == (b.y <= edge_y) )
+                continue;
+            crossings[nb_crossings++] = a.x + (edge_y - a.y) * (b.x - a.x) / (b.y - a.y);
+        }
+        for(i = 1; i < nb_crossings; i++){
+            for(j = i; j > 0 && crossings[j - 1] > crossings[j]; j--){
+                swap = crossings[j];
+                crossings[j] = crossings[j - 1];
+                crossings[j - 1] = swap;
+            }
+        }
+        for(i = 0; i + 1 < nb_crossings; i += 2){
+            for(x = (int16_t)(crossings[i] + 0.5f); x + 0.5f < crossings[i + 1]; x++)
+                stub_set_pixel(context, x, y, context->fill_color);
+        }
+    }
+}
+
+void gpath_draw_outline(GContext *context, GPath *path){
+    int16_t n = path->info.num_points;
+    int16_t half = context->stroke_width / 2;
+    int16_t i, x, y, dx, dy, sx, sy, error, e2, bx, by;
+    GPoint a, b;
+
+    for(i = 0; i < n; i++){
+        a = path->info.points[i];
+        b = path->info.points[(i + 1) % n];
+        x = a.x + path->offset.x;
+        y = a.y + path->offset.y;
+        dx = abs(b.x - a.x);
+        dy = -abs(b.y - a.y);
+        sx = a.x < b.x ? 1 : -1;
+        sy = a.y < b.y ? 1 : -1;
+        error = dx + dy;
+        for(;;){
+            for(by = y - half; by < y - half + context->stroke_width; by++)
+                for(bx = x - half; bx < x - half + context->stroke_width; bx++)
+                    stub_set_pixel(context, bx, by, context->stroke_color);
+            if( x == b.x + path->offset.x && y == b.y + path->offset.y )
+                break;
+            e2 = 2 * error;
+            if( e2 >= dy ){
+                error += dy;
+                x += sx;
+            }
+            if( e2 <= dx ){
+                error += dx;
+                y += sy;
+            }
+        }
+    }
+}
+
+/* ------------------------------- Graphics ----------------------------------*/
+
+GContext *stub_context_create(void){
+    GContext *context = calloc(1, sizeof(GContext));
+
+#if defined(PBL_BW)
+    context->framebuffer.bytes_per_row = 20;
+#else
+    context->framebuffer.bytes_per_row = SCREEN_WIDTH;
+#endif
+    context->framebuffer.bounds = GRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    context->framebuffer.data = calloc(SCREEN_HEIGHT, context->framebuffer.bytes_per_row);
+    return context;
+}
+
+void stub_context_destroy(GContext *context){
+    free(context->framebuffer.data);
+    free(context);
+}
+
+GBitmap *graphics_capture_frame_buffer(GContext *context){
+    return &context->framebuffer;
+}
+
+bool graphics_release_frame_buffer(GContext *context, GBitmap *bitmap){
+    return true;
+}
+
+void graphics_context_set_fill_color(GContext *context, GColor color){
+    context->fill_color = color;
+}
+
+void graphics_context_set_stroke_color(GContext *context, GColor color){
+    context->stroke_color = color;
+}
+
+void graphics_context_set_stroke_width(GContext *context, uint8_t stroke_width){
+    context->stroke_width = stroke_width;
+}
+
+void graphics_context_set_text_color(GContext *context, GColor color){
+}
+
+void graphics_context_set_compositing_mode(GContext *context, GCompOp mode){
+    context->compositing_mode = mode;
+}
+
+/* Only the 4 bit palette bitmaps of the palette rendering are supported */
+void graphics_draw_bitmap_in_rect(GContext *context, const GBitmap *bitmap, GRect rect){
+    GBitmap *framebuffer = &context->framebuffer;
+    int16_t x, y, sx, sy;
+    uint8_t index;
+    GColor color;
+
+    for(sy = 0; sy < rect.size.h && sy < bitmap->bounds.size.h; sy++){
+        y = rect.origin.y + sy;
+        if( y < 0 || y >= framebuffer->bounds.size.h )
+            continue;
+        for(sx = 0; sx < rect.size.w && sx < bitmap->bounds.size.w; sx++){
+            x = rect.origin.x + sx;
+            if( x < 0 || x >= framebuffer->bounds.size.w )
+                continue;
+            index = bitmap->data[sy * bitmap->bytes_per_row + sx / 2];
+            index = (sx & 1) ? (index & 0x0F) : (index >> 4);
+            color = bitmap->palette[index];
+            if( context->compositing_mode == GCompOpSet && color.a == 0 )
+                continue;
+            framebuffer->data[y * framebuffer->bytes_per_row + x] = color.argb;
+        }
+    }
+}
+
+void graphics_draw_text(GContext *context, const char *text, GFont font, GRect box,
+                        GTextOverflowMode overflow_mode, GTextAlignment alignment,
+                        GTextAttributes *text_attributes){
+}
+
+GSize graphics_text_layout_get_content_size(const char *text, GFont font, GRect box,
+                                            GTextOverflowMode overflow_mode,
+                                            GTextAlignment alignment){
+    /* Roughly the width of a Gothic 24 digit */
+    return GSize(strlen(text) * 11, 24);
+}
+
+GFont fonts_get_system_font(const char *font_key){
+    return font_key;
+}